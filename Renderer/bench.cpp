@@ -0,0 +1,28 @@
+#include <iostream>
+#include <cstring>
+
+#include "Benchmark.h"
+
+// bench.exe [--json file] [--filter substring] [--quick]
+int main(int argc, char *argv[]){
+	string jsonFile, filter;
+	bool quick = false;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--json") && i + 1 < argc) jsonFile = argv[++i];
+		else if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+		else if (!strcmp(argv[i], "--quick")) quick = true;
+		else {
+			cerr << "usage: " << argv[0] << " [--json file] [--filter substring] [--quick]" << endl;
+			return 1;
+		}
+	}
+
+	Benchmark bench(filter, quick);
+
+	benchmarkAll(bench);
+
+	if (!jsonFile.empty()) ofstream(jsonFile) << bench.json();
+
+	return 0;
+}
@@ -1,3 +1,6 @@
 #!/bin/bash
 
-g++ -O3 -fopenmp -std=c++11 -Icommon -Iimage -Irender -Itest main.cpp -o main.exe
\ No newline at end of file
+g++ -O3 -fopenmp -std=c++11 -Icommon -Iimage -Irender -Itest main.cpp -o main.exe
+g++ -O3 -fopenmp -std=c++11 -Icommon -Iimage -Irender -Itest bench.cpp -o bench.exe
+g++ -O3 -fopenmp -std=c++11 -Icommon -Iimage -Irender -Itest regress.cpp -o regress.exe
+g++ -O3 -fopenmp -std=c++11 -Icommon -Iimage -Irender -Itest scenegen.cpp -o scenegen.exe
\ No newline at end of file
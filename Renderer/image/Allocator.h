@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     Allocator.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Allocation policies for Matrix storage.
+//
+//                AlignedAllocator: every block starts on a 64-byte boundary (a cache line, and wide
+//                                  enough for any SIMD load).
+//                PooledAllocator:  aligned blocks are kept in a thread-local pool bucketed by size,
+//                                  so the temporaries of repeated filter and render calls reuse
+//                                  memory that is already mapped instead of faulting it in again.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Tells the compiler that returned blocks alias nothing else, as it already assumes for malloc,
+// otherwise every store into a Matrix may clobber any other pointer the optimizer tracks.
+#if defined(_MSC_VER)
+#define ALLOCATOR_RESTRICT __declspec(restrict)
+#elif defined(__GNUC__)
+#define ALLOCATOR_RESTRICT __attribute__((malloc))
+#else
+#define ALLOCATOR_RESTRICT
+#endif
+
+class AlignedAllocator {
+public:
+	static const size_t alignment = 64;
+
+	ALLOCATOR_RESTRICT static void* allocate(size_t bytes);
+
+	static void deallocate(void* p, size_t bytes);
+};
+
+class PooledAllocator {
+public:
+	ALLOCATOR_RESTRICT static void* allocate(size_t bytes);
+
+	static void deallocate(void* p, size_t bytes);
+
+	// Upper bound of the bytes cached by each thread, 256 MB by default.
+	static void setCapacity(size_t bytes) { capacity() = bytes; }
+
+	// Release the blocks cached by the calling thread.
+	static void trim() { if (!destroyed()) pool().clear(); }
+
+	// Bytes currently cached by the calling thread.
+	static size_t cached() { return destroyed() ? 0 : pool().bytes; }
+
+private:
+	// Four classes per power of two, so rounding up wastes at most a quarter of a block.
+	static int sizeClass(size_t bytes, size_t& rounded);
+
+	static std::atomic<size_t>& capacity() {
+		static std::atomic<size_t> value(256u << 20);
+		return value;
+	}
+
+	struct Pool {
+		Pool() : bytes(0) {}
+
+		~Pool() {
+			clear();
+			destroyed() = true;
+		}
+
+		void clear();
+
+		std::vector<std::vector<void*>> buckets;
+		size_t bytes;
+	};
+
+	static Pool& pool() {
+		static thread_local Pool p;
+		return p;
+	}
+
+	// Set once the pool of the calling thread is destroyed. Blocks freed later, by statics and
+	// thread_locals destroyed after it, go straight back to AlignedAllocator. A plain bool needs
+	// no destructor, so it outlives the pool.
+	static bool& destroyed() {
+		static thread_local bool value = false;
+		return value;
+	}
+};
+
+
+void* AlignedAllocator::allocate(size_t bytes) {
+	// The address returned by malloc is kept just below the aligned block.
+	void* raw = std::malloc(bytes + alignment + sizeof(void*));
+	if (raw == nullptr) throw std::bad_alloc();
+
+	const uintptr_t addr = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + alignment - 1) & ~uintptr_t(alignment - 1);
+	void* p = reinterpret_cast<void*>(addr);
+
+	static_cast<void**>(p)[-1] = raw;
+
+	return p;
+}
+
+void AlignedAllocator::deallocate(void* p, size_t) {
+	if (p) std::free(static_cast<void**>(p)[-1]);
+}
+
+
+int PooledAllocator::sizeClass(size_t bytes, size_t& rounded) {
+	const size_t minimum = 64;
+
+	if (bytes <= minimum) {
+		rounded = minimum;
+		return 0;
+	}
+
+	int e = 0;
+	while ((size_t(1) << (e + 1)) < bytes) ++e;
+
+	const size_t quarter = (size_t(1) << e) / 4;
+	const size_t m = (bytes - (size_t(1) << e) + quarter - 1) / quarter;
+
+	rounded = (size_t(1) << e) + m*quarter;
+
+	return (e - 6) * 4 + (int)m;
+}
+
+void* PooledAllocator::allocate(size_t bytes) {
+	size_t rounded;
+	const int idx = sizeClass(bytes, rounded);
+
+	if (destroyed()) return AlignedAllocator::allocate(rounded);
+
+	Pool& p = pool();
+
+	if (idx < (int)p.buckets.size() && !p.buckets[idx].empty()) {
+		void* block = p.buckets[idx].back();
+
+		p.buckets[idx].pop_back();
+		p.bytes -= rounded;
+
+		return block;
+	}
+
+	return AlignedAllocator::allocate(rounded);
+}
+
+void PooledAllocator::deallocate(void* block, size_t bytes) {
+	if (block == nullptr) return;
+
+	size_t rounded;
+	const int idx = sizeClass(bytes, rounded);
+
+	if (destroyed()) {
+		AlignedAllocator::deallocate(block, rounded);
+		return;
+	}
+
+	Pool& p = pool();
+
+	if (p.bytes + rounded > capacity()) {
+		AlignedAllocator::deallocate(block, rounded);
+		return;
+	}
+
+	if (idx >= (int)p.buckets.size()) p.buckets.resize(idx + 1);
+
+	p.buckets[idx].push_back(block);
+	p.bytes += rounded;
+}
+
+void PooledAllocator::Pool::clear() {
+	for (auto& bucket : buckets) {
+		for (void* block : bucket) AlignedAllocator::deallocate(block, 0);
+		bucket.clear();
+	}
+
+	bytes = 0;
+}
@@ -60,6 +60,11 @@ public:
 		return _radius;
 	}
 
+	// The 2*radius+1 weights, from -radius to radius.
+	const vector<double>& data() const {
+		return _data;
+	}
+
 private:
 	int _radius;
 	double _sigma;
@@ -17,8 +17,15 @@
 #pragma once
 
 #include "MyMath.h"
+#include "Matrix.h"
+#include "MatrixView.h"
 #include "GaussianKernel.h"
+#include "SeparableFilter.h"
 #include <algorithm>
+#include <type_traits>
+#include <vector>
+
+using std::vector;
 
 class IP {
 public:
@@ -28,30 +35,83 @@ public:
 	template<typename T>
 	static void meanBlurBruteForce(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius);
 
+	template<typename T>
+	static void meanBlurLinearTime(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius);
+
+	template<typename TIn, typename T>
+	static void meanBlurLinearTime(const MatrixView<TIn>& imInput, const MatrixView<T>& imOutput, int radius);
+
 	template<typename T>
 	static void meanBlurConstantTime(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius);
 
+	template<typename TIn, typename T>
+	static void meanBlurConstantTime(const MatrixView<TIn>& imInput, const MatrixView<T>& imOutput, int radius);
+
 	template<typename T>
 	static void gaussianBlurBruteForce(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius, double sigma);
 
 	template<typename T>
 	static void gaussianBlurLinearTime(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius, double sigma);
 
+	template<typename TIn, typename T>
+	static void gaussianBlurLinearTime(const MatrixView<TIn>& imInput, const MatrixView<T>& imOutput, int radius, double sigma);
+
 	template<typename T>
 	static void gaussianBlurRecursive(const Matrix<T>& imInput, Matrix<T>& imOutput, double sigma);
 
+	template<typename TIn, typename T>
+	static void gaussianBlurRecursive(const MatrixView<TIn>& imInput, const MatrixView<T>& imOutput, double sigma);
+
 	template<typename T>
 	static void bilateralBlurBruteForce(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius, double sigmaS, double sigmaR);
 
 	template<typename T>
 	static void bilateralBlurPorikli(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius, double sigmaS, double sigmaR);
 
+	template<typename TIn, typename T>
+	static void bilateralBlurPorikli(const MatrixView<TIn>& imInput, const MatrixView<T>& imOutput, int radius, double sigmaS, double sigmaR);
+
 	template<typename T>
-	static void bilateralBlurYang(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius, double sigmaS, double sigmaR);
+	static void bilateralBlurYang(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius, double sigmaS, double sigmaR, int bin = 4);
+
+	template<typename TIn, typename T>
+	static void bilateralBlurYang(const MatrixView<TIn>& imInput, const MatrixView<T>& imOutput, int radius, double sigmaS, double sigmaR, int bin = 4);
+
+	template<typename T>
+	static void denoiseATrous(const Matrix<T>& imInput, Matrix<T>& imOutput, const Matrix<float>& albedo, const Matrix<float>& normal,
+		const Matrix<float>& depth, const Matrix<int>& id, int iterations = 4, double sigmaC = 4.0, double sigmaN = 0.3, double sigmaD = 0.05, double sigmaA = 0.1);
 
 private:
+	// Runs filter(input view, output view) into imOutput, reusing its buffer when it has the right size.
+	template<typename T, typename Filter>
+	static void filterInto(const Matrix<T>& imInput, Matrix<T>& imOutput, Filter filter);
+
+	// Accumulator holding exact sums of samples: integers for 8 and 16 bit images, double otherwise.
+	template<typename T>
+	struct BoxSum { using type = double; };
 };
 
+template<>
+struct IP::BoxSum<uint8> { using type = uint32; };
+
+template<>
+struct IP::BoxSum<uint16> { using type = uint64; };
+
+
+template<typename T, typename Filter>
+void IP::filterInto(const Matrix<T>& imInput, Matrix<T>& imOutput, Filter filter) {
+	Matrix<T> im;
+
+	if (!imOutput.identical(imInput) && imOutput.equalSize(imInput))
+		im = std::move(imOutput);
+	else
+		im.create(imInput.height(), imInput.width(), imInput.channel(), false);
+
+	filter(MatrixView<const T>(imInput), MatrixView<T>(im));
+
+	imOutput = std::move(im);
+}
+
 
 
 
@@ -85,7 +145,7 @@ void IP::meanBlurBruteForce(const Matrix<T>& imInput, Matrix<T>& imOutput, int r
 	if (!imOutput.identical(imInput) && imOutput.equalSize(imInput))
 		im = std::move(imOutput);
 	else
-		im.create(height, width, dim);
+		im.create(height, width, dim, false);
 
 	for (int i = 0; i < height; ++i) {
 		for (int j = 0; j < width; ++j) {
@@ -110,12 +170,49 @@ void IP::meanBlurBruteForce(const Matrix<T>& imInput, Matrix<T>& imOutput, int r
 }
 
 
+/*------------------------------------------------------------------------------------------/
+| function:    meanBlurLinearTime
+| description:
+|              The function blurs an given image using a constant spatial filter, applied as two
+|              1D box filters by the separable filter engine.
+|
+|              Time complexity: O(N * r), N: pixel count, r: radius of aperture.
+|
+| input:       @param imInput: the given image.
+|              @param imOutput: output image of the same size and type as imInput.
+|              @param radius: radius of aperture.
+|
+|
+| return:      none
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+template<typename T>
+void IP::meanBlurLinearTime(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius) {
+	assert(!imInput.empty());
+	assert(radius > 0);
+
+	SeparableFilter<double>::box(radius).apply(imInput, imOutput);
+}
+
+// The same on views; imOutput may overlap imInput.
+template<typename TIn, typename T>
+void IP::meanBlurLinearTime(const MatrixView<TIn>& imInput, const MatrixView<T>& imOutput, int radius) {
+	static_assert(std::is_same<typename std::remove_const<TIn>::type, T>::value, "input and output views differ in type");
+	assert(!imInput.empty());
+	assert(radius > 0);
+
+	SeparableFilter<double>::box(radius).apply(imInput, imOutput);
+}
+
+
 /*------------------------------------------------------------------------------------------/
 | function:    meanBlurConstantTime
 | description:
 |              The function blurs an given image using a constant spatial filter.
 |
 |              Time complexity: O(N * 1), N: pixel count.
+|              Column sums slide down each band of rows, and a window slides along the column sums
+|              of each row. The sums are exact integers for 8 and 16 bit images.
 |
 | input:       @param imInput: the given image.
 |              @param imOutput: output image of the same size and type as imInput.
@@ -128,42 +225,104 @@ void IP::meanBlurBruteForce(const Matrix<T>& imInput, Matrix<T>& imOutput, int r
 template<typename T>
 void IP::meanBlurConstantTime(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius) {
 	assert(!imInput.empty());
+
+	filterInto(imInput, imOutput, [&](const MatrixView<const T>& input, const MatrixView<T>& output) {
+		meanBlurConstantTime(input, output, radius);
+	});
+}
+
+// The same on views; imOutput may overlap imInput.
+template<typename TIn, typename T>
+void IP::meanBlurConstantTime(const MatrixView<TIn>& imInput, const MatrixView<T>& imOutput, int radius) {
+	static_assert(std::is_same<typename std::remove_const<TIn>::type, T>::value, "input and output views differ in type");
+	assert(!imInput.empty());
+	assert(imOutput.equalSize(imInput));
 	assert(radius > 0);
 
+	// Bands read rows of their neighbours, so overlapping input is copied first.
+	if (imInput.overlaps(imOutput)) {
+		Matrix<T> im;
+		copyTo(imInput, im);
+		meanBlurConstantTime(MatrixView<const T>(im), imOutput, radius);
+		return;
+	}
+
+	using Acc = typename BoxSum<T>::type;
+
 	const int height = imInput.height();
 	const int width = imInput.width();
 	const int dim = imInput.channel();
+	const int rowLength = width*dim;
+	const int inStride = imInput.pixelStride();
+	const int outStride = imOutput.pixelStride();
 
+	// Windows are clipped at the borders, so they cover fewer samples there.
+	vector<int> colCount(width);
+	for (int j = 0; j < width; ++j)
+		colCount[j] = std::min(width - 1, j + radius) - std::max(0, j - radius) + 1;
 
-	Matrix<double> imIntegral;
-	calcIntegralImage(imInput, imIntegral);
+	// Every band sums 2*radius+1 rows to start, so bands are kept long against the radius.
+	const int bandHeight = std::min(height, std::max(64, 4 * radius));
+	const int bands = (height + bandHeight - 1) / bandHeight;
 
-	Matrix<T> im;
+	#pragma omp parallel
+	{
+		Matrix<Acc> colBuffer;
+		colBuffer.create(1, width, dim, false);
 
-	if (imOutput.identical(imInput) || imOutput.equalSize(imInput))
-		im = std::move(imOutput);
-	else
-		im.create(height, width, dim);
+		Acc* colSum = colBuffer.data();
 
-	for (int i = 0; i < height; ++i) {
-		for (int j = 0; j < width; ++j) {
-			for (int k = 0; k < dim; ++k) {
-				const int top = Math::clip(i - radius - 1, -1, height - 1), bottom = Math::clip(i + radius, 0, height - 1);
-				const int left = Math::clip(j - radius - 1, -1, width - 1), right = Math::clip(j + radius, 0, width - 1);
-				const int pixelNum = (right - left)*(bottom - top);
+		// Adds (sign > 0) or subtracts input row 'row' to the column sums.
+		auto accumulate = [&](int row, int sign) {
+			const TIn* src = &imInput(row, 0);
 
-				const double bottomLeft = left < 0 ? 0 : imIntegral(bottom, left, k);
-				const double topRight = top < 0 ? 0 : imIntegral(top, right, k);
-				const double topLeft = top < 0 ? 0 : (left < 0 ? 0 : imIntegral(top, left, k));
+			if (imInput.packedRows()) {
+				if (sign > 0) for (int x = 0; x < rowLength; ++x) colSum[x] += src[x];
+				else          for (int x = 0; x < rowLength; ++x) colSum[x] -= src[x];
+			}
+			else {
+				for (int j = 0; j < width; ++j)
+					for (int k = 0; k < dim; ++k)
+						colSum[j*dim + k] += sign > 0 ? Acc(src[j*inStride + k]) : Acc(0) - Acc(src[j*inStride + k]);
+			}
+		};
 
-				const double sum = imIntegral(bottom, right, k) - bottomLeft - topRight + topLeft;
+		#pragma omp for schedule(dynamic, 1)
+		for (int band = 0; band < bands; ++band) {
+			const int row0 = band*bandHeight, row1 = std::min(height, row0 + bandHeight);
 
-				im(i, j, k) = (T)(sum / pixelNum);
+			std::fill(colSum, colSum + rowLength, Acc(0));
+
+			for (int i = std::max(0, row0 - radius); i <= std::min(height - 1, row0 + radius); ++i)
+				accumulate(i, 1);
+
+			for (int i = row0; i < row1; ++i) {
+				// slide the column window down, unsigned sums may wrap in between but never in the result
+				if (i > row0) {
+					if (i + radius < height) accumulate(i + radius, 1);
+					if (i - radius - 1 >= 0) accumulate(i - radius - 1, -1);
+				}
+
+				const int rowCount = std::min(height - 1, i + radius) - std::max(0, i - radius) + 1;
+				T* dst = &imOutput(i, 0);
+
+				// slide the row window along the column sums
+				for (int k = 0; k < dim; ++k) {
+					Acc sum = 0;
+
+					for (int j = 0; j <= std::min(radius, width - 1); ++j)
+						sum += colSum[j*dim + k];
+
+					for (int j = 0; j < width; ++j) {
+						dst[j*outStride + k] = (T)(sum / double(rowCount*colCount[j]));
+
+						if (j + radius + 1 < width) sum += colSum[(j + radius + 1)*dim + k];
+						if (j - radius >= 0) sum -= colSum[(j - radius)*dim + k];
+					}
+				}
 			}
 		}
 	}
-
-	imOutput = std::move(im);
 }
 
 
@@ -172,6 +331,9 @@ void IP::meanBlurConstantTime(const Matrix<T>& imInput, Matrix<T>& imOutput, int
 | description:
 |              The function calculate an image's integral image.
 |
+|              Rows are prefix-summed in parallel, then the rows are accumulated downwards in
+|              parallel column blocks.
+|
 | input:       @param imInput: the given image.
 |              @param imOutput: output image of the same size and type as imInput.
 |
@@ -186,17 +348,37 @@ void IP::calcIntegralImage(const Matrix<T>& imInput, Matrix<double>& imOutput) {
 	const int height = imInput.height();
 	const int width = imInput.width();
 	const int dim = imInput.channel();
+	const int rowLength = width*dim;
 
-	Matrix<double> im(height, width, dim);
+	Matrix<double> im;
+	im.create(height, width, dim, false);
 
+	#pragma omp parallel for
 	for (int i = 0; i < height; ++i) {
-		for (int j = 0; j < width; ++j) {
-			for (int k = 0; k < dim; ++k) {
-				if (i == 0 && j == 0) im(i, j, k) = imInput(i, j, k);
-				else if (i != 0 && j == 0) im(i, j, k) = im(i - 1, j, k) + imInput(i, j, k);
-				else if (i == 0 && j != 0) im(i, j, k) = im(i, j - 1, k) + imInput(i, j, k);
-				else im(i, j, k) = im(i - 1, j, k) + im(i, j - 1, k) - im(i - 1, j - 1, k) + imInput(i, j, k);
-			}
+		const T* src = &imInput(i, 0);
+		double* dst = &im(i, 0);
+
+		for (int k = 0; k < dim; ++k)
+			dst[k] = src[k];
+
+		for (int x = dim; x < rowLength; ++x)
+			dst[x] = dst[x - dim] + src[x];
+	}
+
+	// Columns are independent in this pass, so blocks of them go to different threads.
+	const int block = 1024;
+	const int blocks = (rowLength + block - 1) / block;
+
+	#pragma omp parallel for
+	for (int b = 0; b < blocks; ++b) {
+		const int x0 = b*block, x1 = std::min(rowLength, x0 + block);
+
+		for (int i = 1; i < height; ++i) {
+			const double* above = &im(i - 1, 0);
+			double* dst = &im(i, 0);
+
+			for (int x = x0; x < x1; ++x)
+				dst[x] += above[x];
 		}
 	}
 
@@ -237,7 +419,7 @@ void IP::gaussianBlurBruteForce(const Matrix<T>& imInput, Matrix<T>& imOutput, i
 	if (!imOutput.identical(imInput) && imOutput.equalSize(imInput))
 		im = std::move(imOutput);
 	else
-		im.create(height, width, dim);
+		im.create(height, width, dim, false);
 
 	for (int i = 0; i < height; ++i) {
 		for (int j = 0; j < width; ++j) {
@@ -268,6 +450,7 @@ void IP::gaussianBlurBruteForce(const Matrix<T>& imInput, Matrix<T>& imOutput, i
 |              The function blurs an given image using gaussian kernal.
 |
 |              Time complexity: O(N * r), N: pixel count, r: radius of aperture.
+|              The two 1D passes run in the separable filter engine.
 |
 | input:       @param imInput: the given image.
 |              @param imOutput: output image of the same size and type as imInput.
@@ -284,48 +467,18 @@ void IP::gaussianBlurLinearTime(const Matrix<T>& imInput, Matrix<T>& imOutput, i
 	assert(radius > 0);
 	assert(sigma > 0);
 
-	const int height = imInput.height();
-	const int width = imInput.width();
-	const int dim = imInput.channel();
-
-
-	Matrix<T> im1(height, width, dim), im2;
-	GaussianKernel1D kernel(radius, sigma);
-
-	for (int i = 0; i < height; ++i)
-		for (int j = 0; j < width; ++j)
-			for (int k = 0; k < dim; ++k) {
-				double sum = 0;
-
-				for (int di = -radius; di <= radius; ++di) {
-					const int row = Math::clip(i + di, 0, height - 1);
-
-					sum += imInput(row, j, k) * kernel(di);
-				}
-
-				im1(i, j, k) = (T)sum;
-			}
-
-	if (imOutput.identical(imInput) || imOutput.equalSize(imInput))
-		im2 = std::move(imOutput);
-	else
-		im2.create(height, width, dim);
-
-	for (int i = 0; i < height; ++i)
-		for (int j = 0; j < width; ++j)
-			for (int k = 0; k < dim; ++k) {
-				double sum = 0;
-
-				for (int dj = -radius; dj <= radius; ++dj) {
-					const int col = Math::clip(j + dj, 0, width - 1);
-
-					sum += im1(i, col, k) * kernel(dj);
-				}
+	SeparableFilter<double>(GaussianKernel1D(radius, sigma).data()).apply(imInput, imOutput);
+}
 
-				im2(i, j, k) = (T)sum;
-			}
+// The same on views; imOutput may overlap imInput.
+template<typename TIn, typename T>
+void IP::gaussianBlurLinearTime(const MatrixView<TIn>& imInput, const MatrixView<T>& imOutput, int radius, double sigma) {
+	static_assert(std::is_same<typename std::remove_const<TIn>::type, T>::value, "input and output views differ in type");
+	assert(!imInput.empty());
+	assert(radius > 0);
+	assert(sigma > 0);
 
-	imOutput = std::move(im2);
+	SeparableFilter<double>(GaussianKernel1D(radius, sigma).data()).apply(imInput, imOutput);
 }
 
 
@@ -351,8 +504,29 @@ void IP::gaussianBlurLinearTime(const Matrix<T>& imInput, Matrix<T>& imOutput, i
 template<typename T>
 void IP::gaussianBlurRecursive(const Matrix<T>& imInput, Matrix<T>& imOutput, double sigma) {
 	assert(!imInput.empty());
+
+	filterInto(imInput, imOutput, [&](const MatrixView<const T>& input, const MatrixView<T>& output) {
+		gaussianBlurRecursive(input, output, sigma);
+	});
+}
+
+// The same on views; imOutput may overlap imInput.
+template<typename TIn, typename T>
+void IP::gaussianBlurRecursive(const MatrixView<TIn>& imInput, const MatrixView<T>& imOutput, double sigma) {
+	static_assert(std::is_same<typename std::remove_const<TIn>::type, T>::value, "input and output views differ in type");
+	assert(!imInput.empty());
+	assert(imOutput.equalSize(imInput));
 	assert(sigma >= 0);
 
+	// Each row is read completely before it is written, so only a shifted overlap needs a copy.
+	if (imInput.overlaps(imOutput) && (imInput.data() != imOutput.data() ||
+		imInput.rowStride() != imOutput.rowStride() || imInput.pixelStride() != imOutput.pixelStride())) {
+		Matrix<T> im;
+		copyTo(imInput, im);
+		gaussianBlurRecursive(MatrixView<const T>(im), imOutput, sigma);
+		return;
+	}
+
 	const int height = imInput.height();
 	const int width = imInput.width();
 	const int dim = imInput.channel();
@@ -377,66 +551,118 @@ void IP::gaussianBlurRecursive(const Matrix<T>& imInput, Matrix<T>& imOutput, do
 
 	const double B = 1.0 - (b1 + b2 + b3) / b0;
 
-	Matrix<T> im;
+	const int inStride = imInput.pixelStride();
+	const int outStride = imOutput.pixelStride();
 
-	if (!imOutput.identical(imInput) && imOutput.equalSize(imInput))
-		im = std::move(imOutput);
-	else
-		im.create(height, width, dim);
+	// x-axis, all channels of a row are filtered together.
+	#pragma omp parallel
+	{
+		Matrix<double> wxBuffer, outxBuffer;
+		wxBuffer.create(1, width + 3, dim, false);
+		outxBuffer.create(1, width + 3, dim, false);
 
-	// x-axis
-	unique_ptr<double[]> wx(new double[width + 3]);
-	unique_ptr<double[]> outx(new double[width + 3]);
+		double* wx = wxBuffer.data();
+		double* outx = outxBuffer.data();
 
-	for (int k = 0; k < dim; ++k)
+		#pragma omp for
 		for (int i = 0; i < height; ++i) {
-			wx[0] = imInput(i, 0, k);
-			wx[1] = imInput(i, 0, k);
-			wx[2] = imInput(i, 0, k);
+			const TIn* src = &imInput(i, 0);
+			T* dst = &imOutput(i, 0);
+
+			for (int k = 0; k < dim; ++k) {
+				wx[k] = src[k];
+				wx[dim + k] = src[k];
+				wx[2 * dim + k] = src[k];
+			}
 
 			// forward
 			for (int j = 0, n = 3; j < width; ++j, ++n) {
-				wx[n] = B*imInput(i, j, k) + b1_0*wx[n - 1] + b2_0*wx[n - 2] + b3_0*wx[n - 3];
+				for (int k = 0; k < dim; ++k) {
+					const int x = n*dim + k;
+					wx[x] = B*src[j*inStride + k] + b1_0*wx[x - dim] + b2_0*wx[x - 2 * dim] + b3_0*wx[x - 3 * dim];
+				}
 			}
 
-			outx[width + 0] = wx[width + 2];
-			outx[width + 1] = wx[width + 2];
-			outx[width + 2] = wx[width + 2];
+			for (int k = 0; k < dim; ++k) {
+				outx[(width + 0)*dim + k] = wx[(width + 2)*dim + k];
+				outx[(width + 1)*dim + k] = wx[(width + 2)*dim + k];
+				outx[(width + 2)*dim + k] = wx[(width + 2)*dim + k];
+			}
 
 			// backward
 			for (int j = width - 1, n = j; j >= 0; --j, --n) {
-				outx[n] = B*wx[n + 3] + b1_0*outx[n + 1] + b2_0*outx[n + 2] + b3_0*outx[n + 3];
-				im(i, j, k) = (T)outx[n];
+				for (int k = 0; k < dim; ++k) {
+					const int x = n*dim + k;
+					outx[x] = B*wx[x + 3 * dim] + b1_0*outx[x + dim] + b2_0*outx[x + 2 * dim] + b3_0*outx[x + 3 * dim];
+					dst[j*outStride + k] = (T)outx[x];
+				}
 			}
 		}
+	}
 
-	// y-axis
-	unique_ptr<double[]> wy(new double[height + 3]);
-	unique_ptr<double[]> outy(new double[height + 3]);
+	// y-axis, a block of adjacent columns is filtered at once. Each step of the recursion then reads
+	// one short span of a row instead of striding across the whole image.
+	const int blockPixels = std::max(1, 64 / dim);
+	const int block = blockPixels*dim;
+	const int blocks = (width + blockPixels - 1) / blockPixels;
 
-	for (int k = 0; k < dim; ++k)
-		for (int j = 0; j < width; ++j) {
-			wy[0] = im(0, j, k);
-			wy[1] = im(0, j, k);
-			wy[2] = im(0, j, k);
+	#pragma omp parallel
+	{
+		Matrix<double> wyBuffer, outyBuffer;
+		wyBuffer.create(height + 3, block, 1, false);
+		outyBuffer.create(height + 3, block, 1, false);
 
-			// forward
+		double* wy = wyBuffer.data();
+		double* outy = outyBuffer.data();
+
+		#pragma omp for
+		for (int b = 0; b < blocks; ++b) {
+			const int j0 = b*blockPixels;
+			const int pixels = std::min(blockPixels, width - j0);
+			const int len = pixels*dim;
+
+			// forward, the x-axis result is gathered into the line first
 			for (int i = 0, n = 3; i < height; ++i, ++n) {
-				wy[n] = B*im(i, j, k) + b1_0*wy[n - 1] + b2_0*wy[n - 2] + b3_0*wy[n - 3];
+				const T* src = &imOutput(i, j0);
+				double* w = &wy[n*block];
+
+				for (int p = 0; p < pixels; ++p)
+					for (int k = 0; k < dim; ++k)
+						w[p*dim + k] = src[p*outStride + k];
+
+				if (i == 0) {
+					for (int x = 0; x < len; ++x) {
+						wy[x] = w[x];
+						wy[block + x] = w[x];
+						wy[2 * block + x] = w[x];
+					}
+				}
+
+				for (int x = 0; x < len; ++x)
+					w[x] = B*w[x] + b1_0*w[x - block] + b2_0*w[x - 2 * block] + b3_0*w[x - 3 * block];
 			}
 
-			outy[height + 0] = wy[height + 2];
-			outy[height + 1] = wy[height + 2];
-			outy[height + 2] = wy[height + 2];
+			for (int x = 0; x < len; ++x) {
+				outy[(height + 0)*block + x] = wy[(height + 2)*block + x];
+				outy[(height + 1)*block + x] = wy[(height + 2)*block + x];
+				outy[(height + 2)*block + x] = wy[(height + 2)*block + x];
+			}
 
 			// backward
 			for (int i = height - 1, n = i; i >= 0; --i, --n) {
-				outy[n] = B*wy[n + 3] + b1_0*outy[n + 1] + b2_0*outy[n + 2] + b3_0*outy[n + 3];
-				im(i, j, k) = (T)outy[n];
+				const double* w = &wy[(n + 3)*block];
+				double* out = &outy[n*block];
+				T* dst = &imOutput(i, j0);
+
+				for (int x = 0; x < len; ++x)
+					out[x] = B*w[x] + b1_0*out[x + block] + b2_0*out[x + 2 * block] + b3_0*out[x + 3 * block];
+
+				for (int p = 0; p < pixels; ++p)
+					for (int k = 0; k < dim; ++k)
+						dst[p*outStride + k] = (T)out[p*dim + k];
 			}
 		}
-
-	imOutput = std::move(im);
+	}
 }
 
 
@@ -475,7 +701,7 @@ void IP::bilateralBlurBruteForce(const Matrix<T>& imInput, Matrix<T>& imOutput,
 	if (!imOutput.identical(imInput) && imOutput.equalSize(imInput))
 		im = std::move(imOutput);
 	else
-		im.create(height, width, dim);
+		im.create(height, width, dim, false);
 
 	for (int i = 0; i < height; ++i) {
 		for (int j = 0; j < width; ++j) {
@@ -507,9 +733,8 @@ void IP::bilateralBlurBruteForce(const Matrix<T>& imInput, Matrix<T>& imOutput,
 | description:
 |              The function blurs an given image using bilateral filter.
 |
-|              Time complexity: O(N * 1), N: pixel count.
-|              Here, time complexity depends on the gaussianBlur's implementation, for example,
-|              if gaussianBlur's time complexity is O(N*1), then it will be O(N*1).
+|              Time complexity: O(N * r), N: pixel count, r: radius of aperture.
+|              The five power images are blurred in one fused separable pass, see below.
 |
 | input:       @param imInput: the given image.
 |              @param imOutput: output image of the same size and type as imInput.
@@ -527,55 +752,77 @@ void IP::bilateralBlurBruteForce(const Matrix<T>& imInput, Matrix<T>& imOutput,
 template<typename T>
 void IP::bilateralBlurPorikli(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius, double sigmaS, double sigmaR) {
 	assert(!imInput.empty());
+
+	filterInto(imInput, imOutput, [&](const MatrixView<const T>& input, const MatrixView<T>& output) {
+		bilateralBlurPorikli(input, output, radius, sigmaS, sigmaR);
+	});
+}
+
+// The same on views; imOutput may overlap imInput.
+template<typename TIn, typename T>
+void IP::bilateralBlurPorikli(const MatrixView<TIn>& imInput, const MatrixView<T>& imOutput, int radius, double sigmaS, double sigmaR) {
+	static_assert(std::is_same<typename std::remove_const<TIn>::type, T>::value, "input and output views differ in type");
+	assert(!imInput.empty());
+	assert(imOutput.equalSize(imInput));
 	assert(radius > 0);
 	assert(sigmaS > 0 && sigmaR > 0);
 
+	// Tasks read rows of their neighbours, so overlapping input is copied first.
+	if (imInput.overlaps(imOutput)) {
+		Matrix<T> im;
+		copyTo(imInput, im);
+		bilateralBlurPorikli(MatrixView<const T>(im), imOutput, radius, sigmaS, sigmaR);
+		return;
+	}
+
 	const int height = imInput.height();
 	const int width = imInput.width();
 	const int dim = imInput.channel();
-
-	Matrix<T> im;
-	Matrix<double> imgs[5];
-
-	if (!imOutput.identical(imInput) && imOutput.equalSize(imInput))
-		im = std::move(imOutput);
-	else
-		im.create(height, width, dim);
-
-	for (int n = 0; n < 5; ++n) {
-		Matrix<double> img(height, width, dim);
-
-		for (int i = 0; i < height; ++i)
-			for (int j = 0; j < width; ++j)
-				for (int k = 0; k < dim; ++k)
-					img(i, j, k) = std::pow(imInput(i, j, k), n + 1);
-
-		imgs[n] = std::move(img);
-	}
-
-	for (int n = 0; n < 5; ++n)
-		gaussianBlurLinearTime(imgs[n], imgs[n], radius, sigmaS);
+	const int inStride = imInput.pixelStride();
+	const int outStride = imOutput.pixelStride();
 
 	const double alpha = 1.0 / (2 * sigmaR*sigmaR);
 
-	for (int i = 0; i < height; ++i) {
-		for (int j = 0; j < width; ++j) {
-			for (int k = 0; k < dim; ++k) {
-				// Apply the Taylor expansion to Gaussian range filter, we obtain the bilateral filter
-				// expansion up to the second order derivatives.
-				const double sum = imgs[0](i, j, k) + 2 * alpha*imInput(i, j, k)*imgs[1](i, j, k)
-					+ alpha*(2 * alpha*imInput(i, j, k)*imInput(i, j, k) - 1)*imgs[2](i, j, k)
-					- 2 * alpha*alpha*imInput(i, j, k)*imgs[3](i, j, k) + 0.5*alpha*alpha*imgs[4](i, j, k);
-				const double kappa = 1.0 + 2 * alpha*imInput(i, j, k)*imgs[0](i, j, k)
-					+ alpha*(2 * alpha*imInput(i, j, k)*imInput(i, j, k) - 1)*imgs[1](i, j, k)
-					- 2 * alpha*alpha*imInput(i, j, k)*imgs[2](i, j, k) + 0.5*alpha*alpha*imgs[3](i, j, k);
-
-				im(i, j, k) = (T)(sum / kappa);
+	// The five powers x, x^2, .., x^5 of every sample are generated while a row is loaded and
+	// blurred together as 5*dim interleaved channels; the final combine is done on each blurred
+	// row as it leaves the vertical pass. Only the engine's ring buffers are allocated.
+	SeparableFilter<double>(GaussianKernel1D(radius, sigmaS).data()).apply(height, width, dim * 5,
+		[&](int row, int col0, int col1, double* dst) {
+			const TIn* src = &imInput(row, col0);
+
+			for (int j = 0; j < col1 - col0; ++j) {
+				for (int k = 0; k < dim; ++k, dst += 5) {
+					const double v = src[j*inStride + k];
+
+					dst[0] = v;
+					dst[1] = dst[0] * v;
+					dst[2] = dst[1] * v;
+					dst[3] = dst[2] * v;
+					dst[4] = dst[3] * v;
+				}
 			}
-		}
-	}
-
-	imOutput = std::move(im);
+		},
+		[&](int row, int col0, int col1, const double* imgs) {
+			const TIn* src = &imInput(row, col0);
+			T* dst = &imOutput(row, col0);
+
+			for (int j = 0; j < col1 - col0; ++j) {
+				for (int k = 0; k < dim; ++k, imgs += 5) {
+					const double v = src[j*inStride + k];
+
+					// Apply the Taylor expansion to Gaussian range filter, we obtain the bilateral filter
+					// expansion up to the second order derivatives.
+					const double sum = imgs[0] + 2 * alpha*v*imgs[1]
+						+ alpha*(2 * alpha*v*v - 1)*imgs[2]
+						- 2 * alpha*alpha*v*imgs[3] + 0.5*alpha*alpha*imgs[4];
+					const double kappa = 1.0 + 2 * alpha*v*imgs[0]
+						+ alpha*(2 * alpha*v*v - 1)*imgs[1]
+						- 2 * alpha*alpha*v*imgs[2] + 0.5*alpha*alpha*imgs[3];
+
+					dst[j*outStride + k] = (T)(sum / kappa);
+				}
+			}
+		});
 }
 
 
@@ -584,15 +831,17 @@ void IP::bilateralBlurPorikli(const Matrix<T>& imInput, Matrix<T>& imOutput, int
 | description:
 |              The function blurs an given image using bilateral filter.
 |
-|              Time complexity: O(N * 1), N: pixel count.
-|              Here, time complexity depends on the gaussianBlur's implementation, for example,
-|              if gaussianBlur's time complexity is O(N*1), then it will be O(N*1).
+|              Time complexity: O(N * r * bin), N: pixel count, r: radius of aperture.
+|              The PBFICs are generated per tile while rows are loaded and blurred in float by
+|              one fused separable pass; the interpolation is done as the rows leave it. For
+|              uint8 / uint16 input the range kernel is a table lookup.
 |
 | input:       @param imInput: the given image.
 |              @param imOutput: output image of the same size and type as imInput.
 |              @param radius: radius of the aperture.
 |              @param sigmaD: spatial variance.
 |              @param sigmaR: range variance.
+|              @param bin: number of PBFICs, at least 2.
 |
 |
 | return:      none
@@ -602,73 +851,261 @@ void IP::bilateralBlurPorikli(const Matrix<T>& imInput, Matrix<T>& imOutput, int
 | pdf:         http://vision.ai.illinois.edu/publications/cvpr-09-qingxiong-yang.pdf
 |-----------------------------------------------------------------------------------------*/
 template<typename T>
-void IP::bilateralBlurYang(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius, double sigmaS, double sigmaR) {
+void IP::bilateralBlurYang(const Matrix<T>& imInput, Matrix<T>& imOutput, int radius, double sigmaS, double sigmaR, int bin) {
 	assert(!imInput.empty());
+
+	filterInto(imInput, imOutput, [&](const MatrixView<const T>& input, const MatrixView<T>& output) {
+		bilateralBlurYang(input, output, radius, sigmaS, sigmaR, bin);
+	});
+}
+
+// The same on views; imOutput may overlap imInput.
+template<typename TIn, typename T>
+void IP::bilateralBlurYang(const MatrixView<TIn>& imInput, const MatrixView<T>& imOutput, int radius, double sigmaS, double sigmaR, int bin) {
+	static_assert(std::is_same<typename std::remove_const<TIn>::type, T>::value, "input and output views differ in type");
+	assert(!imInput.empty());
+	assert(imOutput.equalSize(imInput));
 	assert(radius > 0);
 	assert(sigmaS > 0 && sigmaR > 0);
+	assert(bin >= 2); // Number of PBFICs(Principle Bilateral Filtered Image Component)
+
+	// Tasks read rows of their neighbours, so overlapping input is copied first.
+	if (imInput.overlaps(imOutput)) {
+		Matrix<T> im;
+		copyTo(imInput, im);
+		bilateralBlurYang(MatrixView<const T>(im), imOutput, radius, sigmaS, sigmaR, bin);
+		return;
+	}
 
 	const int height = imInput.height();
 	const int width = imInput.width();
 	const int dim = imInput.channel();
-	const int bin = 4; // Number of PBFICs(Principle Bilateral Filtered Image Component)
-	const int pixelNum = height*width*dim;
+	const int inStride = imInput.pixelStride();
+	const int outStride = imOutput.pixelStride();
+
+	T minSample = imInput(0, 0), maxSample = imInput(0, 0);
+
+	for (int i = 0; i < height; ++i) {
+		const TIn* src = &imInput(i, 0);
+
+		for (int j = 0; j < width; ++j) {
+			for (int k = 0; k < dim; ++k) {
+				minSample = std::min(minSample, src[j*inStride + k]);
+				maxSample = std::max(maxSample, src[j*inStride + k]);
+			}
+		}
+	}
 
-	double grayScale[bin];
-	const double minValue = *std::min_element(imInput.data(), imInput.data() + pixelNum);
-	const double maxValue = *std::max_element(imInput.data(), imInput.data() + pixelNum);
+	const double minValue = minSample;
+	const double maxValue = maxSample;
 	const double step = (maxValue - minValue) / (bin - 1);
 
+	// A flat image is its own bilateral filtered result.
+	if (step <= 0) {
+		copyTo(imInput, imOutput);
+		return;
+	}
+
+	vector<double> grayScale(bin);
+
 	grayScale[0] = minValue;
 	grayScale[bin - 1] = maxValue;
 	for (int i = 1; i < bin - 1; ++i)
 		grayScale[i] = minValue + step*i;
 
-	Matrix<double> W[bin], J[bin];
+	const double a = 1.0 / (2 * sigmaR*sigmaR);
 
-	for (int n = 0; n < bin; ++n) {
-		Matrix<double> wn(height, width, dim), jn(height, width, dim);
+	// For uint8 / uint16 every possible sample value is tabulated: its range weight for each PBFIC,
+	// and the two PBFICs it is interpolated from.
+	const bool lookup = std::is_integral<T>::value && sizeof(T) <= 2;
+	const int levels = lookup ? int(maxValue - minValue) + 1 : 0;
 
-		for (int i = 0; i < height; ++i)
-			for (int j = 0; j < width; ++j)
-				for (int k = 0; k < dim; ++k) {
-					// If T is uint8 or uint16, this can be optimized by table lookup.
-					wn(i, j, k) = std::exp(-std::pow(imInput(i, j, k) - grayScale[n], 2) / (2 * sigmaR*sigmaR));
-					jn(i, j, k) = wn(i, j, k)*imInput(i, j, k);
-				}
+	vector<float> weightTable(levels*bin);
+	vector<int> idxTable(levels);
+	vector<double> alphaTable(levels);
 
-		W[n] = std::move(wn);
-		J[n] = std::move(jn);
-	}
+	for (int v = 0; v < levels; ++v) {
+		const double value = minValue + v;
 
-	for (int n = 0; n < bin; ++n) {
-		gaussianBlurLinearTime(W[n], W[n], radius, sigmaS);
-		gaussianBlurLinearTime(J[n], J[n], radius, sigmaS);
+		for (int n = 0; n < bin; ++n)
+			weightTable[v*bin + n] = (float)std::exp(-(value - grayScale[n])*(value - grayScale[n])*a);
+
+		idxTable[v] = std::min(int(v / step), bin - 2);
+		alphaTable[v] = (value - grayScale[idxTable[v]]) / step;
 	}
 
-	for (int n = 0; n < bin; ++n)
-		for (int i = 0; i < height; ++i)
-			for (int j = 0; j < width; ++j)
+	// Every sample carries the pairs (W, J) of all PBFICs, interleaved.
+	SeparableFilter<float>(GaussianKernel1D(radius, sigmaS).data()).apply(height, width, dim * bin * 2,
+		[&](int row, int col0, int col1, float* dst) {
+			const TIn* src = &imInput(row, col0);
+
+			for (int j = 0; j < col1 - col0; ++j) {
+				for (int k = 0; k < dim; ++k, dst += 2 * bin) {
+					const double v = src[j*inStride + k];
+
+					for (int n = 0; n < bin; ++n) {
+						const float w = lookup ? weightTable[int(v - minValue)*bin + n]
+							: (float)std::exp(-(v - grayScale[n])*(v - grayScale[n])*a);
+
+						dst[2 * n] = w;
+						dst[2 * n + 1] = w*(float)v;
+					}
+				}
+			}
+		},
+		[&](int row, int col0, int col1, const float* pbfic) {
+			const TIn* src = &imInput(row, col0);
+			T* dst = &imOutput(row, col0);
+
+			for (int j = 0; j < col1 - col0; ++j) {
+				for (int k = 0; k < dim; ++k, pbfic += 2 * bin) {
+					const double v = src[j*inStride + k];
+					int idx;
+					double alpha;
+
+					if (lookup) {
+						idx = idxTable[int(v - minValue)];
+						alpha = alphaTable[int(v - minValue)];
+					}
+					else {
+						idx = std::min(int((v - minValue) / step), bin - 2);
+						alpha = (v - grayScale[idx]) / step;
+					}
+
+					// The blurred weight only underflows when the whole aperture is far from the level.
+					const float* lo = pbfic + 2 * idx;
+					const float* hi = lo + 2;
+					const double jLo = lo[0] > 0 ? lo[1] / lo[0] : v;
+					const double jHi = hi[0] > 0 ? hi[1] / hi[0] : v;
+
+					dst[j*outStride + k] = T((1 - alpha)*jLo + alpha*jHi);
+				}
+			}
+		});
+}
+
+
+/*------------------------------------------------------------------------------------------/
+| function:    denoiseATrous
+| description:
+|              The function denoises a rendered image with the edge-avoiding a-trous wavelet
+|              transform, guided by first-hit buffers of the render (see AOV.h).
+|
+|              Every iteration is a 5x5 B3 spline filter whose taps are 2^i pixels apart, so
+|              the support doubles each time while the cost does not. A tap is weighted down by
+|              its distance to the centre pixel in colour, normal, relative depth and albedo, and
+|              dropped when it sees another object. The colour tolerance halves each iteration.
+|
+|              Time complexity: O(N * iterations), N: pixel count.
+|
+| input:       @param imInput: the given image, e.g. the linear colour AOV.
+|              @param imOutput: output image of the same size and type as imInput.
+|              @param albedo, normal: 3 channel guides, or empty.
+|              @param depth, id: 1 channel guides, or empty.
+|              @param iterations: number of levels.
+|              @param sigmaC, sigmaN, sigmaD, sigmaA: tolerance of colour, normal, depth and albedo.
+|
+|
+| return:      none
+| note:        [10/19/2026]
+|
+| reference:   "Edge-Avoiding A-Trous Wavelet Transform for fast Global Illumination Filtering"
+| pdf:         https://jo.dreggn.org/home/2010_atrous.pdf
+|-----------------------------------------------------------------------------------------*/
+template<typename T>
+void IP::denoiseATrous(const Matrix<T>& imInput, Matrix<T>& imOutput, const Matrix<float>& albedo, const Matrix<float>& normal,
+	const Matrix<float>& depth, const Matrix<int>& id, int iterations, double sigmaC, double sigmaN, double sigmaD, double sigmaA) {
+	assert(!imInput.empty());
+	assert(iterations > 0);
+	assert(sigmaC > 0 && sigmaN > 0 && sigmaD > 0 && sigmaA > 0);
+
+	const int height = imInput.height();
+	const int width = imInput.width();
+	const int dim = imInput.channel();
+
+	const bool useAlbedo = !albedo.empty(), useNormal = !normal.empty(), useDepth = !depth.empty(), useId = !id.empty();
+
+	assert(!useAlbedo || (albedo.height() == height && albedo.width() == width && albedo.channel() == 3));
+	assert(!useNormal || (normal.height() == height && normal.width() == width && normal.channel() == 3));
+	assert(!useDepth || (depth.height() == height && depth.width() == width && depth.channel() == 1));
+	assert(!useId || (id.height() == height && id.width() == width && id.channel() == 1));
+
+	// B3 spline
+	const float kernel[5] = { 1.0f / 16, 1.0f / 4, 3.0f / 8, 1.0f / 4, 1.0f / 16 };
+
+	const float normalFactor = float(1.0 / (sigmaN*sigmaN));
+	const float depthFactor = float(1.0 / (sigmaD*sigmaD));
+	const float albedoFactor = float(1.0 / (sigmaA*sigmaA));
+
+	// Integer images are filtered in [0, 1], so the tolerances mean the same for every type.
+	const float scale = std::is_integral<T>::value ? 255.0f : 1.0f;
+
+	Matrix<float> im = cast<float>(imInput) / scale, next;
+	next.create(height, width, dim, false);
+
+	auto distance3 = [](const float* a, const float* b) {
+		return (a[0] - b[0])*(a[0] - b[0]) + (a[1] - b[1])*(a[1] - b[1]) + (a[2] - b[2])*(a[2] - b[2]);
+	};
+
+	for (int n = 0; n < iterations; ++n) {
+		const int step = 1 << n;
+		const float colorFactor = float(std::ldexp(1.0 / (sigmaC*sigmaC), 2 * n));
+
+		#pragma omp parallel for schedule(dynamic, 8)
+		for (int i = 0; i < height; ++i) {
+			for (int j = 0; j < width; ++j) {
+				const float* center = &im(i, j);
+				float* dst = &next(i, j);
+				float weightSum = 0;
+
 				for (int k = 0; k < dim; ++k)
-					J[n](i, j, k) /= W[n](i, j, k);
+					dst[k] = 0;
 
+				for (int dy = -2; dy <= 2; ++dy) {
+					const int y = i + dy*step;
+					if (y < 0 || y >= height) continue;
 
-	Matrix<T> im;
+					for (int dx = -2; dx <= 2; ++dx) {
+						const int x = j + dx*step;
+						if (x < 0 || x >= width) continue;
+						if (useId && id(y, x) != id(i, j)) continue;
 
-	if (!imOutput.identical(imInput) && imOutput.equalSize(imInput))
-		im = std::move(imOutput);
-	else
-		im.create(height, width, dim);
+						const float* tap = &im(y, x);
+						float e = 0;
 
-	for (int i = 0; i < height; ++i)
-		for (int j = 0; j < width; ++j)
-			for (int k = 0; k < dim; ++k) {
-				int idx = int((imInput(i, j, k) - minValue) / step);
-				if (idx + 1 == bin) --idx;
+						for (int k = 0; k < dim; ++k)
+							e += (tap[k] - center[k])*(tap[k] - center[k]);
+
+						e *= colorFactor;
+
+						if (useNormal) e += distance3(&normal(y, x), &normal(i, j))*normalFactor;
+						if (useAlbedo) e += distance3(&albedo(y, x), &albedo(i, j))*albedoFactor;
 
-				const double alpha = (imInput(i, j, k) - grayScale[idx]) / step;
+						if (useDepth) {
+							const float dz = (depth(y, x) - depth(i, j)) / std::max(depth(i, j), 1e-3f);
+							e += dz*dz*depthFactor;
+						}
+
+						const float w = kernel[dy + 2] * kernel[dx + 2] * std::exp(-e);
+
+						for (int k = 0; k < dim; ++k)
+							dst[k] += w*tap[k];
+
+						weightSum += w;
+					}
+				}
 
-				im(i, j, k) = T((1 - alpha)*J[idx](i, j, k) + alpha*J[idx + 1](i, j, k));
+				// The centre tap always counts, so weightSum > 0.
+				for (int k = 0; k < dim; ++k)
+					dst[k] /= weightSum;
 			}
+		}
 
-	imOutput = std::move(im);
-}
\ No newline at end of file
+		std::swap(im, next);
+	}
+
+	if (std::is_integral<T>::value)
+		imOutput = cast<T>(clip(im * scale + 0.5f, 0.0f, scale));
+	else
+		imOutput = cast<T>(im);
+}
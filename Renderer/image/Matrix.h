@@ -20,6 +20,8 @@
 #include <tuple>
 #include <cstring>
 
+#include "Allocator.h"
+
 using uint8 = unsigned char;
 using uint16 = unsigned short;
 using uint32 = unsigned int;
@@ -47,7 +49,11 @@ private:
 	std::tuple<int,int,int> _size;
 };
 
-template<typename T>
+template<typename E>
+class MatrixExpr;
+
+// T must be trivially copyable: the storage is raw memory, copied with memcpy.
+template<typename T, typename Allocator = PooledAllocator>
 class Matrix {
 public:
 	// Prevent heap allocation
@@ -56,7 +62,8 @@ public:
 	void  operator delete(void*) = delete;
 	void  operator delete[](void*) = delete;
 
-	void create(int height, int width, int channel);
+	// Pass zeroFill = false when every element is about to be overwritten.
+	void create(int height, int width, int channel, bool zeroFill = true);
 
 	Matrix()
 		: _data(nullptr)
@@ -79,26 +86,47 @@ public:
 		destory();
 	}
 
-	Matrix(const Matrix<T>& rhs) {
-		create(rhs.height(), rhs.width(), rhs.channel());
+	Matrix(const Matrix& rhs) : Matrix() {
+		create(rhs.height(), rhs.width(), rhs.channel(), false);
 		memcpy(_data, rhs._data, sizeof(T)*_length);
 	}
 
-	Matrix<T>& operator = (const Matrix<T>& rhs) {
-		create(rhs.height(), rhs.width(), rhs.channel());
-		memcpy(_data, rhs._data, sizeof(T)*_length);
+	Matrix& operator = (const Matrix& rhs) {
+		if (this != &rhs) {
+			create(rhs.height(), rhs.width(), rhs.channel(), false);
+			memcpy(_data, rhs._data, sizeof(T)*_length);
+		}
 		return *this;
 	}
 
-	Matrix(Matrix<T>&& rhs) : Matrix() {
+	Matrix(Matrix&& rhs) : Matrix() {
 		swap(rhs);
 	}
 
-	Matrix<T>& operator = (Matrix&& rhs) {
+	Matrix& operator = (Matrix&& rhs) {
 		swap(rhs);
 		return *this;
 	}
 
+	// Element-wise expressions are evaluated in one pass, see MatrixExpr.h.
+	template<typename E>
+	Matrix(const MatrixExpr<E>& expr);
+
+	template<typename E>
+	Matrix& operator = (const MatrixExpr<E>& expr);
+
+	template<typename X>
+	Matrix& operator += (const X& rhs);
+
+	template<typename X>
+	Matrix& operator -= (const X& rhs);
+
+	template<typename X>
+	Matrix& operator *= (const X& rhs);
+
+	template<typename X>
+	Matrix& operator /= (const X& rhs);
+
 	T& operator() (int row, int col, int channel = 0) {
 		return _data[row*_width_x_channel + col*_channel + channel];
 	}
@@ -124,15 +152,15 @@ public:
 	template<typename U>
 	friend Size size(const Matrix<U>& m);
 
-	bool identical(const Matrix<T>& rhs) const { return this == &rhs; }
+	bool identical(const Matrix& rhs) const { return this == &rhs; }
 
-	bool equalSize(const Matrix<T>& rhs) const { 
+	bool equalSize(const Matrix& rhs) const { 
 		return _height == rhs._height && _width == rhs._width && _channel == rhs._channel;
 	}
 
 private:
 	void destory();
-	void swap(Matrix<T>& rhs);
+	void swap(Matrix& rhs);
 
 private:
 	T* _data;
@@ -141,29 +169,35 @@ private:
 	int _width_x_channel, _length;
 };
 
-template<typename T>
-void Matrix<T>::create(int height, int width, int channel) {
+template<typename T, typename Allocator>
+void Matrix<T, Allocator>::create(int height, int width, int channel, bool zeroFill) {
 	assert(height > 0 && width > 0 && channel > 0);
 
-	destory();
-	
+	// The buffer is kept when only the shape changes.
+	if (_data == nullptr || _length != height*width*channel) {
+		destory();
+
+		_data = static_cast<T*>(Allocator::allocate(sizeof(T)*height*width*channel));
+	}
+
 	_height  = height;
 	_width   = width;
 	_channel = channel;
 	_width_x_channel = width*channel;
 	_length = height*width*channel;
 
-	_data = new T[_length];
-	memset(_data, 0, sizeof(T)*_length);
+	if (zeroFill)
+		memset(_data, 0, sizeof(T)*_length);
 }
 
-template<typename T>
-void Matrix<T>::destory() {
-	delete[] _data;
+template<typename T, typename Allocator>
+void Matrix<T, Allocator>::destory() {
+	Allocator::deallocate(_data, sizeof(T)*_length);
+	_data = nullptr;
 }
 
-template<typename T>
-void Matrix<T>::swap(Matrix<T>& rhs) {
+template<typename T, typename Allocator>
+void Matrix<T, Allocator>::swap(Matrix& rhs) {
 	std::swap(_data, rhs._data);
 	std::swap(_height, rhs._height);
 	std::swap(_width, rhs._width);
@@ -174,5 +208,7 @@ void Matrix<T>::swap(Matrix<T>& rhs) {
 
 template<typename U>
 Size size(const Matrix<U>& m) { 
-	return Size(m.height(), m.width(), m.channel); 
-}
\ No newline at end of file
+	return Size(m.height(), m.width(), m.channel()); 
+}
+
+#include "MatrixExpr.h"
@@ -0,0 +1,326 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     MatrixExpr.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Lazy element-wise arithmetic on Matrix.
+//
+//                Operators + - * / between matrices and scalars, and pow, exp, clip, cast<U>, build
+//                an expression tree instead of computing anything. Assigning the tree to a Matrix
+//                evaluates it in a single loop over the elements, so
+//
+//                    J = clip(cast<float>(a) * w + b / 2, 0.0f, 1.0f);
+//
+//                makes no temporaries. The loop is split across threads for large matrices. An
+//                expression refers to its matrices, it must not outlive them. Element types follow
+//                the usual C++ promotions; the result is converted to the element type of the
+//                destination on assignment.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Matrix.h"
+#include "MyMath.h"
+
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+template<typename E>
+class MatrixExpr {
+public:
+	const E& self() const { return static_cast<const E&>(*this); }
+};
+
+
+// Leaves
+
+template<typename T>
+class MatrixTerm : public MatrixExpr<MatrixTerm<T>> {
+public:
+	using value_type = T;
+
+	template<typename Allocator>
+	explicit MatrixTerm(const Matrix<T, Allocator>& m)
+		: _data(m.data())
+		, _size(m.height(), m.width(), m.channel())
+	{}
+
+	value_type operator[] (int i) const { return _data[i]; }
+
+	Size size() const { return _size; }
+
+private:
+	const T* _data;
+	Size _size;
+};
+
+template<typename S>
+class ScalarTerm : public MatrixExpr<ScalarTerm<S>> {
+public:
+	using value_type = S;
+
+	explicit ScalarTerm(S value) : _value(value) {}
+
+	value_type operator[] (int) const { return _value; }
+
+	// A scalar fits any size.
+	Size size() const { return Size(); }
+
+private:
+	S _value;
+};
+
+
+// Nodes
+
+template<typename Op, typename L, typename R>
+class BinaryExpr : public MatrixExpr<BinaryExpr<Op, L, R>> {
+public:
+	using value_type = decltype(Op::apply(std::declval<typename L::value_type>(), std::declval<typename R::value_type>()));
+
+	BinaryExpr(const L& lhs, const R& rhs)
+		: _lhs(lhs)
+		, _rhs(rhs) {
+		assert(lhs.size() == Size() || rhs.size() == Size() || lhs.size() == rhs.size());
+	}
+
+	value_type operator[] (int i) const { return Op::apply(_lhs[i], _rhs[i]); }
+
+	Size size() const { return _lhs.size() == Size() ? _rhs.size() : _lhs.size(); }
+
+private:
+	L _lhs;
+	R _rhs;
+};
+
+template<typename Op, typename E>
+class UnaryExpr : public MatrixExpr<UnaryExpr<Op, E>> {
+public:
+	using value_type = decltype(Op::apply(std::declval<typename E::value_type>()));
+
+	explicit UnaryExpr(const E& e) : _e(e) {}
+
+	value_type operator[] (int i) const { return Op::apply(_e[i]); }
+
+	Size size() const { return _e.size(); }
+
+private:
+	E _e;
+};
+
+template<typename E>
+class ClipExpr : public MatrixExpr<ClipExpr<E>> {
+public:
+	using value_type = typename E::value_type;
+
+	ClipExpr(const E& e, value_type low, value_type high)
+		: _e(e)
+		, _low(low)
+		, _high(high) {
+		assert(low <= high);
+	}
+
+	value_type operator[] (int i) const { return Math::clip(_e[i], _low, _high); }
+
+	Size size() const { return _e.size(); }
+
+private:
+	E _e;
+	value_type _low, _high;
+};
+
+template<typename U, typename E>
+class CastExpr : public MatrixExpr<CastExpr<U, E>> {
+public:
+	using value_type = U;
+
+	explicit CastExpr(const E& e) : _e(e) {}
+
+	value_type operator[] (int i) const { return (U)_e[i]; }
+
+	Size size() const { return _e.size(); }
+
+private:
+	E _e;
+};
+
+
+// Element operations
+
+struct AddOp {
+	template<typename A, typename B>
+	static auto apply(A a, B b) -> decltype(a + b) { return a + b; }
+};
+
+struct SubOp {
+	template<typename A, typename B>
+	static auto apply(A a, B b) -> decltype(a - b) { return a - b; }
+};
+
+struct MulOp {
+	template<typename A, typename B>
+	static auto apply(A a, B b) -> decltype(a * b) { return a * b; }
+};
+
+struct DivOp {
+	template<typename A, typename B>
+	static auto apply(A a, B b) -> decltype(a / b) { return a / b; }
+};
+
+struct PowOp {
+	template<typename A, typename B>
+	static auto apply(A a, B b) -> decltype(std::pow(a, b)) { return std::pow(a, b); }
+};
+
+struct ExpOp {
+	template<typename A>
+	static auto apply(A a) -> decltype(std::exp(a)) { return std::exp(a); }
+};
+
+
+// Operands: a Matrix is referred to by a MatrixTerm, an arithmetic value becomes a ScalarTerm,
+// an expression is copied into its parent node.
+
+template<typename X, typename = void>
+struct ExprOf {};
+
+template<typename X>
+struct ExprOf<X, typename std::enable_if<std::is_base_of<MatrixExpr<X>, X>::value>::type> {
+	using type = X;
+
+	static const type& get(const X& x) { return x; }
+};
+
+template<typename T, typename Allocator>
+struct ExprOf<Matrix<T, Allocator>> {
+	using type = MatrixTerm<T>;
+
+	static type get(const Matrix<T, Allocator>& m) { return type(m); }
+};
+
+template<typename S>
+struct ExprOf<S, typename std::enable_if<std::is_arithmetic<S>::value>::type> {
+	using type = ScalarTerm<S>;
+
+	static type get(S s) { return type(s); }
+};
+
+template<typename X>
+struct IsMatrixOperand : std::is_base_of<MatrixExpr<X>, X> {};
+
+template<typename T, typename Allocator>
+struct IsMatrixOperand<Matrix<T, Allocator>> : std::true_type {};
+
+// At least one side must be a matrix or an expression, the other may be a scalar.
+template<typename L, typename R>
+struct EnableBinary : std::enable_if<
+	(IsMatrixOperand<L>::value && (IsMatrixOperand<R>::value || std::is_arithmetic<R>::value)) ||
+	(IsMatrixOperand<R>::value && std::is_arithmetic<L>::value)> {};
+
+template<typename Op, typename L, typename R>
+using BinaryExprOf = BinaryExpr<Op, typename ExprOf<L>::type, typename ExprOf<R>::type>;
+
+
+template<typename L, typename R, typename = typename EnableBinary<L, R>::type>
+BinaryExprOf<AddOp, L, R> operator + (const L& lhs, const R& rhs) {
+	return BinaryExprOf<AddOp, L, R>(ExprOf<L>::get(lhs), ExprOf<R>::get(rhs));
+}
+
+template<typename L, typename R, typename = typename EnableBinary<L, R>::type>
+BinaryExprOf<SubOp, L, R> operator - (const L& lhs, const R& rhs) {
+	return BinaryExprOf<SubOp, L, R>(ExprOf<L>::get(lhs), ExprOf<R>::get(rhs));
+}
+
+template<typename L, typename R, typename = typename EnableBinary<L, R>::type>
+BinaryExprOf<MulOp, L, R> operator * (const L& lhs, const R& rhs) {
+	return BinaryExprOf<MulOp, L, R>(ExprOf<L>::get(lhs), ExprOf<R>::get(rhs));
+}
+
+template<typename L, typename R, typename = typename EnableBinary<L, R>::type>
+BinaryExprOf<DivOp, L, R> operator / (const L& lhs, const R& rhs) {
+	return BinaryExprOf<DivOp, L, R>(ExprOf<L>::get(lhs), ExprOf<R>::get(rhs));
+}
+
+template<typename L, typename R, typename = typename EnableBinary<L, R>::type>
+BinaryExprOf<PowOp, L, R> pow(const L& base, const R& exponent) {
+	return BinaryExprOf<PowOp, L, R>(ExprOf<L>::get(base), ExprOf<R>::get(exponent));
+}
+
+template<typename X, typename = typename std::enable_if<IsMatrixOperand<X>::value>::type>
+UnaryExpr<ExpOp, typename ExprOf<X>::type> exp(const X& x) {
+	return UnaryExpr<ExpOp, typename ExprOf<X>::type>(ExprOf<X>::get(x));
+}
+
+template<typename X, typename S, typename = typename std::enable_if<IsMatrixOperand<X>::value>::type>
+ClipExpr<typename ExprOf<X>::type> clip(const X& x, S low, S high) {
+	return ClipExpr<typename ExprOf<X>::type>(ExprOf<X>::get(x), low, high);
+}
+
+template<typename U, typename X, typename = typename std::enable_if<IsMatrixOperand<X>::value>::type>
+CastExpr<U, typename ExprOf<X>::type> cast(const X& x) {
+	return CastExpr<U, typename ExprOf<X>::type>(ExprOf<X>::get(x));
+}
+
+
+// Evaluation
+
+template<typename T, typename Allocator>
+template<typename E>
+Matrix<T, Allocator>::Matrix(const MatrixExpr<E>& expr) : Matrix() {
+	*this = expr;
+}
+
+template<typename T, typename Allocator>
+template<typename E>
+Matrix<T, Allocator>& Matrix<T, Allocator>::operator = (const MatrixExpr<E>& expr) {
+	const E& e = expr.self();
+	const Size size = e.size();
+
+	// Operands have the size of the result, so this keeps the buffer of a matrix the
+	// expression reads from; each element is read before it is written.
+	create(size.height(), size.width(), size.channel(), false);
+
+	// Below this threshold starting the threads costs more than the loop.
+	const int parallelLength = 1 << 16;
+	const int length = _length;
+	T* dst = _data;
+
+	#pragma omp parallel for if (length >= parallelLength)
+	for (int i = 0; i < length; ++i)
+		dst[i] = (T)e[i];
+
+	return *this;
+}
+
+template<typename T, typename Allocator>
+template<typename X>
+Matrix<T, Allocator>& Matrix<T, Allocator>::operator += (const X& rhs) {
+	return *this = *this + rhs;
+}
+
+template<typename T, typename Allocator>
+template<typename X>
+Matrix<T, Allocator>& Matrix<T, Allocator>::operator -= (const X& rhs) {
+	return *this = *this - rhs;
+}
+
+template<typename T, typename Allocator>
+template<typename X>
+Matrix<T, Allocator>& Matrix<T, Allocator>::operator *= (const X& rhs) {
+	return *this = *this * rhs;
+}
+
+template<typename T, typename Allocator>
+template<typename X>
+Matrix<T, Allocator>& Matrix<T, Allocator>::operator /= (const X& rhs) {
+	return *this = *this / rhs;
+}
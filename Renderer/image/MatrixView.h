@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     MatrixView.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Non-owning view of matrix data with strides.
+//
+//                Element (row, col, channel) lives at data[row*rowStride + col*pixelStride + channel],
+//                so a view can cover a whole Matrix, a rectangular region of it, or a single channel
+//                of it, without copying. Views are cheap to pass by value; constness of the viewed
+//                data is part of T, as with pointers: MatrixView<const uint8> is read-only.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Matrix.h"
+
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+
+template<typename T>
+class MatrixView {
+public:
+	using value_type = typename std::remove_const<T>::type;
+
+	MatrixView()
+		: _data(nullptr)
+		, _height(0)
+		, _width(0)
+		, _channel(0)
+		, _rowStride(0)
+		, _pixelStride(0)
+	{}
+
+	MatrixView(T* data, int height, int width, int channel, int rowStride, int pixelStride)
+		: _data(data)
+		, _height(height)
+		, _width(width)
+		, _channel(channel)
+		, _rowStride(rowStride)
+		, _pixelStride(pixelStride)
+	{}
+
+	// The whole matrix.
+	template<typename Allocator>
+	MatrixView(Matrix<value_type, Allocator>& m)
+		: MatrixView(m.data(), m.height(), m.width(), m.channel(), m.width()*m.channel(), m.channel())
+	{}
+
+	// The whole matrix, read-only.
+	template<typename Allocator, typename U = T, typename = typename std::enable_if<std::is_const<U>::value>::type>
+	MatrixView(const Matrix<value_type, Allocator>& m)
+		: MatrixView(m.data(), m.height(), m.width(), m.channel(), m.width()*m.channel(), m.channel())
+	{}
+
+	// MatrixView<U> -> MatrixView<const U>
+	template<typename U, typename = typename std::enable_if<std::is_same<const U, T>::value>::type>
+	MatrixView(const MatrixView<U>& rhs)
+		: MatrixView(rhs.data(), rhs.height(), rhs.width(), rhs.channel(), rhs.rowStride(), rhs.pixelStride())
+	{}
+
+	T& operator() (int row, int col, int channel = 0) const {
+		return _data[row*_rowStride + col*_pixelStride + channel];
+	}
+
+	// Rows [top, top + height), columns [left, left + width).
+	MatrixView roi(int top, int left, int height, int width) const {
+		assert(top >= 0 && left >= 0 && height > 0 && width > 0);
+		assert(top + height <= _height && left + width <= _width);
+
+		return MatrixView(&(*this)(top, left), height, width, _channel, _rowStride, _pixelStride);
+	}
+
+	// Channel k alone, as a one channel view.
+	MatrixView channelOf(int k) const {
+		assert(k >= 0 && k < _channel);
+
+		return MatrixView(_data + k, _height, _width, 1, _rowStride, _pixelStride);
+	}
+
+	int height()      const { return _height;      }
+
+	int width()       const { return _width;       }
+
+	int channel()     const { return _channel;     }
+
+	int rowStride()   const { return _rowStride;   }
+
+	int pixelStride() const { return _pixelStride; }
+
+	T* data()         const { return _data;        }
+
+	bool empty()      const { return _data == nullptr; }
+
+	// The pixels of a row are packed, so a row is one contiguous run of width*channel elements.
+	bool packedRows() const { return _pixelStride == _channel; }
+
+	template<typename U>
+	bool equalSize(const MatrixView<U>& rhs) const {
+		return _height == rhs.height() && _width == rhs.width() && _channel == rhs.channel();
+	}
+
+	// Whether the address ranges spanned by two views intersect.
+	template<typename U>
+	bool overlaps(const MatrixView<U>& rhs) const {
+		if (empty() || rhs.empty()) return false;
+
+		const uintptr_t first = reinterpret_cast<uintptr_t>(_data);
+		const uintptr_t last = reinterpret_cast<uintptr_t>(&(*this)(_height - 1, _width - 1, _channel - 1) + 1);
+		const uintptr_t rhsFirst = reinterpret_cast<uintptr_t>(rhs.data());
+		const uintptr_t rhsLast = reinterpret_cast<uintptr_t>(&rhs(rhs.height() - 1, rhs.width() - 1, rhs.channel() - 1) + 1);
+
+		return first < rhsLast && rhsFirst < last;
+	}
+
+private:
+	T* _data;
+
+	int _height, _width, _channel;
+	int _rowStride, _pixelStride;
+};
+
+
+/*------------------------------------------------------------------------------------------/
+| function:    copyTo
+| description:
+|              The function copies the elements of a view into a packed matrix of its size.
+|
+| input:       @param view: the given view.
+|              @param m: output matrix.
+|
+| return:      none
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+template<typename T, typename U, typename Allocator>
+void copyTo(const MatrixView<T>& view, Matrix<U, Allocator>& m) {
+	assert(!view.empty());
+
+	const int rowLength = view.width()*view.channel();
+
+	m.create(view.height(), view.width(), view.channel(), false);
+
+	for (int i = 0; i < view.height(); ++i) {
+		U* dst = &m(i, 0);
+
+		if (view.packedRows()) {
+			const T* src = &view(i, 0);
+
+			for (int x = 0; x < rowLength; ++x)
+				dst[x] = (U)src[x];
+		}
+		else {
+			for (int j = 0; j < view.width(); ++j)
+				for (int k = 0; k < view.channel(); ++k)
+					dst[j*view.channel() + k] = (U)view(i, j, k);
+		}
+	}
+}
+
+
+/*------------------------------------------------------------------------------------------/
+| function:    copyTo
+| description:
+|              The function copies the elements of a view into another view of the same size.
+|              The views must not overlap, unless they address the same elements.
+|
+| input:       @param src: the given view.
+|              @param dst: output view.
+|
+| return:      none
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+template<typename T, typename U>
+void copyTo(const MatrixView<T>& src, const MatrixView<U>& dst) {
+	assert(!src.empty());
+	assert(dst.equalSize(src));
+
+	for (int i = 0; i < src.height(); ++i)
+		for (int j = 0; j < src.width(); ++j)
+			for (int k = 0; k < src.channel(); ++k)
+				dst(i, j, k) = (U)src(i, j, k);
+}
@@ -9,7 +9,7 @@
 // 
 // Date:          2016.10.28
 // 
-// Description:   A toolkit to read/write PPM / PGM / PBM image files.
+// Description:   A toolkit to read/write PPM / PGM / PBM image files, and linear RGB images as PFM.
 //
 // 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -25,6 +25,7 @@
 #include "MyString.h"
 #include "MyException.h"
 #include "Matrix.h"
+#include "MatrixView.h"
 
 using namespace std;
 
@@ -33,7 +34,19 @@ public:
 
 	static Matrix<uint8> open(const string& filepath);
 
-	static void save(const Matrix<uint8>& mat, const string& filepath, const ImageType& type = ImageType::P6, bool ascii = false);
+	// Size of a binary PPM / PGM image, read from its header alone.
+	static Size openSize(const string& filepath);
+
+	// Rows [top, top + height) and columns [left, left + width) of a binary PPM / PGM image, as RGB.
+	// Only the requested rows are read, so it never holds the whole image.
+	static Matrix<uint8> openRegion(const string& filepath, int top, int left, int height, int width);
+
+	static void save(const MatrixView<const uint8>& mat, const string& filepath, const ImageType& type = ImageType::P6, bool ascii = false);
+
+	// 3 channel float images, e.g. unclipped radiance, as little endian PFM.
+	static Matrix<float> openFloat(const string& filepath);
+
+	static void saveFloat(const Matrix<float>& mat, const string& filepath);
 
 private:
 	struct Header {
@@ -49,6 +62,8 @@ private:
 
 	static Header parseHeader(ifstream& file);
 
+	static Header parseBinaryHeader(ifstream& file, const string& filepath);
+
 	void readPPM(const string& filepath);
 };
 
@@ -138,7 +153,54 @@ Matrix<uint8> PXMImage::open(const string& filepath){
 }
 
 
-void PXMImage::save(const Matrix<uint8>& mat, const string& filepath, const ImageType& type, bool ascii){
+PXMImage::Header PXMImage::parseBinaryHeader(ifstream& file, const string& filepath) {
+	if (!file) throw Exception("Can not open " + filepath + "!");
+
+	auto header = parseHeader(file);
+
+	if (header._type != ImageType::P5 && header._type != ImageType::P6) throw Exception("Only binary PGM / PPM images can be read by region!");
+	if (header._mmax > 255) throw Exception("Only 8 bit images can be read by region!");
+
+	return header;
+}
+
+Size PXMImage::openSize(const string& filepath) {
+	ifstream file(filepath, ios::in | ios::binary);
+	auto header = parseBinaryHeader(file, filepath);
+
+	return Size(header._height, header._width, 3);
+}
+
+Matrix<uint8> PXMImage::openRegion(const string& filepath, int top, int left, int height, int width) {
+	ifstream file(filepath, ios::in | ios::binary);
+	auto header = parseBinaryHeader(file, filepath);
+
+	if (top < 0 || left < 0 || height <= 0 || width <= 0 || top + height > header._height || left + width > header._width)
+		throw Exception("Region is out of the image!");
+
+	const int fileChannel = header._type == ImageType::P6 ? 3 : 1;
+	const streamoff start = file.tellg();
+	const streamoff rowLength = (streamoff)header._width * fileChannel;
+
+	Matrix<uint8> mat(height, width, 3);
+	unique_ptr<uint8[]> buf(new uint8[width * fileChannel]);
+
+	for (int i = 0; i < height; ++i) {
+		file.seekg(start + (top + i) * rowLength + left * fileChannel);
+		file.read((char*)buf.get(), width * fileChannel);
+
+		if (!file) throw Exception("Image data is corrupted!");
+
+		for (int j = 0; j < width; ++j)
+			for (int k = 0; k < 3; ++k)
+				mat(i, j, k) = buf[j * fileChannel + (fileChannel == 3 ? k : 0)];
+	}
+
+	return mat;
+}
+
+
+void PXMImage::save(const MatrixView<const uint8>& mat, const string& filepath, const ImageType& type, bool ascii){
 	ofstream file(filepath.c_str(), ios::out | ios::binary);
 	const int width = mat.width();
 	const int height = mat.height();
@@ -165,5 +227,45 @@ void PXMImage::save(const Matrix<uint8>& mat, const string& filepath, const Imag
 		file.write((char*)buf.get(), len*sizeof(uint8));
 	}
 
+	file.close();
+}
+
+
+Matrix<float> PXMImage::openFloat(const string& filepath) {
+	ifstream file(filepath, ios::in | ios::binary);
+
+	if (!file) throw Exception("Can not open " + filepath + "!");
+
+	string name;
+	int width = 0, height = 0;
+	double scale = 0;
+
+	file >> name >> width >> height >> scale;
+	file.get();
+
+	if (name != "PF" || width <= 0 || height <= 0) throw Exception("File header is wrong!");
+	if (scale >= 0) throw Exception("Only little endian PFM images can be read!");
+
+	Matrix<float> mat(height, width, 3);
+
+	// Rows are stored bottom to top.
+	for (int i = height - 1; i >= 0; --i)
+		file.read((char*)&mat(i, 0), width * 3 * sizeof(float));
+
+	if (!file) throw Exception("Image data is corrupted!");
+
+	return mat;
+}
+
+void PXMImage::saveFloat(const Matrix<float>& mat, const string& filepath) {
+	if (mat.channel() != 3) throw Exception("PFM images must have 3 channels!");
+
+	ofstream file(filepath.c_str(), ios::out | ios::binary);
+
+	file << String::format("PF\n%d %d\n-1.0\n", mat.width(), mat.height());
+
+	for (int i = mat.height() - 1; i >= 0; --i)
+		file.write((const char*)&mat(i, 0), mat.width() * 3 * sizeof(float));
+
 	file.close();
 }
\ No newline at end of file
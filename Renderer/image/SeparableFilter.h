@@ -0,0 +1,295 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     SeparableFilter.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Cache-blocked separable convolution engine.
+//
+//                The image is cut into vertical strips narrow enough for the intermediate rows of a
+//                strip to stay in L2, and each strip into bands of rows. Every (strip, band) task
+//                runs the horizontal pass row by row into a ring buffer of 2*radius+1 rows, then the
+//                vertical pass reads that ring. Borders are replicated when a row is loaded and
+//                when the ring rows are picked, so the tap loops never clip a coordinate. Common
+//                radii are compiled with a constant tap count and unroll completely.
+//
+//                Input and output go through two functors, so callers can convert, generate or
+//                combine pixels on the fly instead of materializing full images:
+//
+//                    void load (int row, int col0, int col1, Acc* dst);        // input columns [col0, col1)
+//                    void store(int row, int col0, int col1, const Acc* src);  // output columns [col0, col1)
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Matrix.h"
+#include "MatrixView.h"
+#include "MyMath.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+using std::vector;
+
+template<typename Acc>
+class SeparableFilter {
+public:
+	// 'taps' holds the 2*radius+1 weights of the 1D kernel, applied along both axes.
+	explicit SeparableFilter(const vector<double>& taps)
+		: _radius((int)taps.size() / 2)
+		, _taps(taps.begin(), taps.end()) {
+		assert(taps.size() % 2 == 1);
+	}
+
+	static SeparableFilter box(int radius) {
+		assert(radius > 0);
+
+		return SeparableFilter(vector<double>(2 * radius + 1, 1.0 / (2 * radius + 1)));
+	}
+
+	int radius() const { return _radius; }
+
+	template<typename Loader, typename Sink>
+	void apply(int height, int width, int dim, Loader load, Sink store) const;
+
+	template<typename T>
+	void apply(const Matrix<T>& imInput, Matrix<T>& imOutput) const;
+
+	template<typename T, typename U>
+	void apply(const MatrixView<T>& imInput, const MatrixView<U>& imOutput) const;
+
+private:
+	template<int R, typename Loader, typename Sink>
+	void run(int height, int width, int dim, Loader& load, Sink& store) const;
+
+	template<int R>
+	void convolve(const Acc* const* src, Acc* dst, int length) const;
+
+private:
+	int _radius;
+	vector<Acc> _taps;
+};
+
+
+/*------------------------------------------------------------------------------------------/
+| function:    apply
+| description:
+|              The function convolves a height x width x dim image with the kernel along both
+|              axes, reading rows through 'load' and writing them through 'store'.
+|
+| input:       @param height, width, dim: size of the image.
+|              @param load: input row functor.
+|              @param store: output row functor.
+|
+| return:      none
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+template<typename Acc>
+template<typename Loader, typename Sink>
+void SeparableFilter<Acc>::apply(int height, int width, int dim, Loader load, Sink store) const {
+	assert(height > 0 && width > 0 && dim > 0);
+
+	switch (_radius) {
+	case 1: run<1>(height, width, dim, load, store); break;
+	case 2: run<2>(height, width, dim, load, store); break;
+	case 3: run<3>(height, width, dim, load, store); break;
+	case 4: run<4>(height, width, dim, load, store); break;
+	case 5: run<5>(height, width, dim, load, store); break;
+	case 6: run<6>(height, width, dim, load, store); break;
+	case 7: run<7>(height, width, dim, load, store); break;
+	case 8: run<8>(height, width, dim, load, store); break;
+	default: run<0>(height, width, dim, load, store); break;
+	}
+}
+
+
+/*------------------------------------------------------------------------------------------/
+| function:    apply
+| description:
+|              The function filters a matrix. imOutput may be imInput.
+|
+| input:       @param imInput: the given image.
+|              @param imOutput: output image of the same size and type as imInput.
+|
+| return:      none
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+template<typename Acc>
+template<typename T>
+void SeparableFilter<Acc>::apply(const Matrix<T>& imInput, Matrix<T>& imOutput) const {
+	assert(!imInput.empty());
+
+	const int height = imInput.height();
+	const int width = imInput.width();
+	const int dim = imInput.channel();
+
+	Matrix<T> im;
+
+	if (!imOutput.identical(imInput) && imOutput.equalSize(imInput))
+		im = std::move(imOutput);
+	else
+		im.create(height, width, dim, false);
+
+	apply(MatrixView<const T>(imInput), MatrixView<T>(im));
+
+	imOutput = std::move(im);
+}
+
+
+/*------------------------------------------------------------------------------------------/
+| function:    apply
+| description:
+|              The function filters a view into a view of the same size, e.g. a tile, a crop
+|              or one channel of a larger image. The views may overlap.
+|
+| input:       @param imInput: the given view.
+|              @param imOutput: output view of the same size as imInput.
+|
+| return:      none
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+template<typename Acc>
+template<typename T, typename U>
+void SeparableFilter<Acc>::apply(const MatrixView<T>& imInput, const MatrixView<U>& imOutput) const {
+	assert(!imInput.empty());
+	assert(imOutput.equalSize(imInput));
+
+	// Tasks read rows of their neighbours, so overlapping input is copied first.
+	if (imInput.overlaps(imOutput)) {
+		Matrix<typename MatrixView<T>::value_type> im;
+		copyTo(imInput, im);
+		apply(MatrixView<const typename MatrixView<T>::value_type>(im), imOutput);
+		return;
+	}
+
+	const int dim = imInput.channel();
+
+	apply(imInput.height(), imInput.width(), dim,
+		[&](int row, int col0, int col1, Acc* dst) {
+			for (int j = col0; j < col1; ++j)
+				for (int k = 0; k < dim; ++k)
+					*dst++ = (Acc)imInput(row, j, k);
+		},
+		[&](int row, int col0, int col1, const Acc* src) {
+			for (int j = col0; j < col1; ++j)
+				for (int k = 0; k < dim; ++k)
+					imOutput(row, j, k) = (U)*src++;
+		});
+}
+
+
+template<typename Acc>
+template<int R, typename Loader, typename Sink>
+void SeparableFilter<Acc>::run(int height, int width, int dim, Loader& load, Sink& store) const {
+	const int radius = R > 0 ? R : _radius;
+	const int size = 2 * radius + 1;
+
+	// Keep the ring of one strip around 256 KB; bands are long enough to amortize the 2*radius
+	// rows every band has to load again.
+	const int cacheBytes = 256 * 1024;
+	const int stripWidth = std::min(width, std::max(16, cacheBytes / int((size + 1)*dim*sizeof(Acc))));
+	const int bandHeight = std::min(height, std::max(128, 8 * radius));
+	const int strips = (width + stripWidth - 1) / stripWidth;
+	const int bands = (height + bandHeight - 1) / bandHeight;
+	const int tasks = strips*bands;
+
+	#pragma omp parallel
+	{
+		Matrix<Acc> paddedBuffer, ringBuffer, outBuffer;
+		paddedBuffer.create(1, stripWidth + 2 * radius, dim, false);
+		ringBuffer.create(size, stripWidth, dim, false);
+		outBuffer.create(1, stripWidth, dim, false);
+
+		Acc* padded = paddedBuffer.data();
+		Acc* ring = ringBuffer.data();
+		Acc* out = outBuffer.data();
+		vector<const Acc*> src(size);
+
+		#pragma omp for schedule(dynamic, 1)
+		for (int task = 0; task < tasks; ++task) {
+			const int col0 = (task % strips)*stripWidth, col1 = std::min(width, col0 + stripWidth);
+			const int row0 = (task / strips)*bandHeight, row1 = std::min(height, row0 + bandHeight);
+			const int length = (col1 - col0)*dim;
+
+			// Columns outside the image are replicated from the border ones.
+			const int left = std::max(0, col0 - radius), right = std::min(width, col1 + radius);
+			const int leftPad = left - (col0 - radius), paddedWidth = col1 - col0 + 2 * radius;
+			Acc* first = &padded[leftPad*dim];
+			Acc* last = &padded[(leftPad + right - left - 1)*dim];
+
+			int next = std::max(0, row0 - radius);
+
+			for (int i = row0; i < row1; ++i) {
+				// horizontal pass for every input row the window of row i needs
+				for (; next <= std::min(height - 1, i + radius); ++next) {
+					load(next, left, right, first);
+
+					for (int j = 0; j < leftPad; ++j)
+						std::copy(first, first + dim, &padded[j*dim]);
+
+					for (int j = leftPad + right - left; j < paddedWidth; ++j)
+						std::copy(last, last + dim, &padded[j*dim]);
+
+					for (int t = 0; t < size; ++t)
+						src[t] = &padded[t*dim];
+
+					convolve<R>(src.data(), &ring[(next % size)*stripWidth*dim], length);
+				}
+
+				// vertical pass, rows outside the image are replicated from the border ones
+				for (int t = 0; t < size; ++t)
+					src[t] = &ring[(Math::clip(i + t - radius, 0, height - 1) % size)*stripWidth*dim];
+
+				convolve<R>(src.data(), out, length);
+				store(i, col0, col1, out);
+			}
+		}
+	}
+}
+
+
+template<typename Acc>
+template<int R>
+void SeparableFilter<Acc>::convolve(const Acc* const* src, Acc* dst, int length) const {
+	const Acc* taps = _taps.data();
+
+	if (R > 0) {
+		// Local copies, so the compiler knows the stores to dst can't change them.
+		const Acc* s[2 * R + 1];
+		Acc w[2 * R + 1];
+
+		for (int t = 0; t < 2 * R + 1; ++t) {
+			s[t] = src[t];
+			w[t] = taps[t];
+		}
+
+		for (int x = 0; x < length; ++x) {
+			Acc sum = 0;
+
+			for (int t = 0; t < 2 * R + 1; ++t)
+				sum += s[t][x] * w[t];
+
+			dst[x] = sum;
+		}
+	}
+	else {
+		// Tap by tap, so the inner loop still runs over contiguous memory.
+		for (int x = 0; x < length; ++x)
+			dst[x] = src[0][x] * taps[0];
+
+		for (int t = 1; t < 2 * _radius + 1; ++t) {
+			const Acc* s = src[t];
+			const Acc w = taps[t];
+
+			for (int x = 0; x < length; ++x)
+				dst[x] += s[x] * w;
+		}
+	}
+}
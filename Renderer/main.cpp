@@ -25,7 +25,12 @@ int main(int argc, char *argv[]){
 	//mat = renderICM(size, samples);
 
 	mat = globalIlluminationTest(size, samples);
+	//mat = globalIlluminationDenoiseTest(size, samples);
+	//mat = globalIlluminationFilmTest(size, samples, make_shared<MitchellFilter>());
+	//mat = globalIlluminationProfileTest(size, samples);
 	//planeAndSphereTest();
+	//textureTest();
+	//textureCacheTest();
 
 	//smallpt();
 
@@ -0,0 +1,49 @@
+#include <iostream>
+#include <cstring>
+
+#include "Regression.h"
+
+// regress.exe [--size WxH] [--budget sec] [--references dir] [--make-references spp] [--history file]
+//             [--threshold fraction] [--target relMSE] [--scene substring] [--label text]
+int main(int argc, char *argv[]){
+	Regression::Options options;
+	int referenceSamples = 0;
+
+	for (int i = 1; i < argc; ++i) {
+		const bool value = i + 1 < argc;
+		int w = 0, h = 0;
+
+		if (!strcmp(argv[i], "--size") && value && sscanf(argv[i + 1], "%dx%d", &w, &h) == 2) { options.size = Size(h, w, 3); ++i; }
+		else if (!strcmp(argv[i], "--budget") && value) options.budgetSeconds = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--references") && value) options.referenceDir = argv[++i];
+		else if (!strcmp(argv[i], "--make-references") && value) referenceSamples = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--history") && value) options.historyFile = argv[++i];
+		else if (!strcmp(argv[i], "--threshold") && value) options.threshold = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--target") && value) options.targetRelMSE = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--scene") && value) options.filter = argv[++i];
+		else if (!strcmp(argv[i], "--label") && value) options.label = argv[++i];
+		else {
+			cerr << "usage: " << argv[0] << " [--size WxH] [--budget sec] [--references dir] [--make-references spp] [--history file]"
+				" [--threshold fraction] [--target relMSE] [--scene substring] [--label text]" << endl;
+			return 2;
+		}
+	}
+
+	if (referenceSamples > 0) {
+		options.referenceSamples = referenceSamples;
+		Regression(options).makeReferences();
+		return 0;
+	}
+
+	int regressed = 0;
+
+	for (const Regression::Result& result : Regression(options).run())
+		regressed += result.regressed;
+
+	if (regressed > 0) {
+		cerr << regressed << " scene(s) regressed by more than " << options.threshold * 100 << "%" << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     AABB.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Axis aligned bounding box.
+//
+//                The default box is empty, and growing it by a point or a box gives their bounds.
+//                Unbounded geometry, such as a plane, has the infinite box.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Vector3D.h"
+
+#include <algorithm>
+#include <limits>
+
+class AABB {
+public:
+	AABB()
+		: _min(std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity())
+		, _max(-std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity())
+	{}
+
+	AABB(const Vector3D& min, const Vector3D& max) : _min(min), _max(max) {}
+
+	static AABB infinite() {
+		const double inf = std::numeric_limits<double>::infinity();
+		return AABB(Vector3D(-inf, -inf, -inf), Vector3D(inf, inf, inf));
+	}
+
+	const Vector3D& getMin() const { return _min; }
+
+	const Vector3D& getMax() const { return _max; }
+
+	bool isEmpty() const { return _min.x() > _max.x() || _min.y() > _max.y() || _min.z() > _max.z(); }
+
+	bool isFinite() const {
+		return std::isfinite(_min.x()) && std::isfinite(_min.y()) && std::isfinite(_min.z())
+			&& std::isfinite(_max.x()) && std::isfinite(_max.y()) && std::isfinite(_max.z());
+	}
+
+	AABB& expand(const Vector3D& point) {
+		_min = Vector3D(std::min(_min.x(), point.x()), std::min(_min.y(), point.y()), std::min(_min.z(), point.z()));
+		_max = Vector3D(std::max(_max.x(), point.x()), std::max(_max.y(), point.y()), std::max(_max.z(), point.z()));
+		return *this;
+	}
+
+	AABB& expand(const AABB& box) {
+		if (box.isEmpty()) return *this;
+		return expand(box._min).expand(box._max);
+	}
+
+	Vector3D center() const { return (_min + _max) * 0.5; }
+
+	// Zero for an empty box; the cost metric of the BVH.
+	double surfaceArea() const {
+		if (isEmpty()) return 0;
+
+		const Vector3D d = _max - _min;
+		return 2 * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+	}
+
+	// Grown by 'margin' on every side.
+	AABB padded(double margin) const {
+		return AABB(_min - Vector3D(margin, margin, margin), _max + Vector3D(margin, margin, margin));
+	}
+
+	// Whether the segment origin + t*direction, t in [tmin, tmax], touches the box.
+	bool intersect(const Vector3D& origin, const Vector3D& direction, double tmin, double tmax) const;
+
+	// Distance at which a ray enters the box, clamped to 0, or infinity if it misses the box
+	// before 'tmax'; 'inverse' is 1 / direction, per axis.
+	double hit(const Vector3D& origin, const Vector3D& inverse, double tmax) const {
+		double tmin = 0;
+
+		for (int axis = 0; axis < 3; ++axis) {
+			double t0 = (_min[axis] - origin[axis]) * inverse[axis];
+			double t1 = (_max[axis] - origin[axis]) * inverse[axis];
+
+			if (t0 > t1) std::swap(t0, t1);
+			if (t0 > tmin) tmin = t0;
+			if (t1 < tmax) tmax = t1;
+		}
+
+		return tmin <= tmax ? tmin : std::numeric_limits<double>::infinity();
+	}
+
+private:
+	Vector3D _min, _max;
+};
+
+
+bool AABB::intersect(const Vector3D& origin, const Vector3D& direction, double tmin, double tmax) const {
+	for (int axis = 0; axis < 3; ++axis) {
+		const double o = origin[axis], d = direction[axis];
+		const double lo = _min[axis], hi = _max[axis];
+
+		if (d == 0) {
+			if (o < lo || o > hi) return false;
+			continue;
+		}
+
+		double t0 = (lo - o) / d, t1 = (hi - o) / d;
+		if (t0 > t1) std::swap(t0, t1);
+
+		if (t0 > tmin) tmin = t0;
+		if (t1 < tmax) tmax = t1;
+
+		if (tmin > tmax) return false;
+	}
+
+	return true;
+}
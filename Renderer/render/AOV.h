@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     AOV.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Arbitrary output variables of a render: the linear colour, and the properties of the
+//                first surface hit through the centre of every pixel, to guide a denoiser.
+//
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Matrix.h"
+
+struct AOV {
+	Matrix<float> color;   // 3 channels, mean radiance of all samples, linear and not clipped
+	Matrix<float> albedo;  // 3 channels, getColor() of the material
+	Matrix<float> normal;  // 3 channels, unit normal facing the camera
+	Matrix<float> depth;   // distance along the camera ray, 0 on a miss
+	Matrix<int> id;        // Geometry::getId(), -1 on a miss
+
+	void create(int height, int width) {
+		color.create(height, width, 3, false);
+		albedo.create(height, width, 3, false);
+		normal.create(height, width, 3, false);
+		depth.create(height, width, 1, false);
+		id.create(height, width, 1, false);
+	}
+};
@@ -0,0 +1,302 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     AnimationRenderer.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Renders the frames of an animation on a RenderQueue and saves them while later
+//                frames render.
+//
+//                The geometry, materials and lights given to the constructor stay resident and are
+//                shared by all frames. A frame only copies what it changes: keyframed spheres and
+//                whatever the update callback modifies. The copies keep the ids of the originals.
+//                Frames in flight therefore never share a mutable object, and a frame costs a
+//                vector of pointers plus the moved objects.
+//
+//                Several frames render at once, enough to keep every thread busy when frames have
+//                few rows. A writer thread saves finished frames in order.
+//
+//                Ray traced animations may instead be rendered incrementally: one frame after the
+//                other, each tracing only the pixels the changes since the last frame can reach.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RenderQueue.h"
+#include "IncrementalRayTracer.h"
+#include "BVH.h"
+#include "Sphere.h"
+#include "PXMImage.h"
+#include "MyString.h"
+#include "MyException.h"
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+
+// The scene of one frame, as seen by the update callback.
+class AnimationFrame {
+public:
+	AnimationFrame(int index, const vector<shared_ptr<Geometry>>& geometries, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera)
+		: index(index)
+		, geometries(geometries)
+		, lights(lights)
+		, camera(camera) {
+	}
+
+	const int index;
+
+	// The resident geometry, and what this frame replaced or added.
+	vector<shared_ptr<Geometry>> geometries;
+
+	vector<shared_ptr<Light>> lights;
+
+	PerspectiveCamera camera;
+
+	// A copy of a resident geometry, in its place for this frame only; change the copy, never the
+	// original, which other frames may be rendering.
+	template<typename T>
+	shared_ptr<T> modify(const shared_ptr<T>& geometry);
+
+private:
+	std::map<const Geometry*, shared_ptr<Geometry>> _copies;
+};
+
+class AnimationRenderer {
+public:
+	struct Options {
+		RenderJob::Method method = RenderJob::RAY_TRACE;
+		int samples = 1;            // path tracing
+		int maxReflect = 5;         // ray tracing
+		Size size = Size(300, 400, 3);
+
+		// printf pattern of the frame files, given the frame index.
+		std::string pattern = "frame%04d.ppm";
+
+		// Frames rendering at once; 0 chooses enough to give every thread rows to trace.
+		int framesInFlight = 0;
+		int priority = 0;
+
+		// Ray tracing only: IncrementalRayTracer in place of the queue.
+		bool incremental = false;
+
+		// Frames traced through a BVH, each made from the last one's by its changes.
+		bool accelerate = false;
+
+		// Called on the caller's thread with the index of every frame saved.
+		std::function<void(int)> saved;
+	};
+
+	typedef std::function<void(AnimationFrame& frame)> Update;
+
+	AnimationRenderer(const vector<shared_ptr<Geometry>>& geometries, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera,
+					  const Options& options, RenderQueue& queue = defaultQueue());
+
+	// Sphere center at 'frame', linearly interpolated between keyframes and held before the first
+	// and after the last.
+	void addKeyframe(const shared_ptr<Sphere>& sphere, int frame, const Vector3D& center);
+
+	// Renders and saves frames [first, last); update runs for each frame after the keyframes.
+	void render(int first, int last, const Update& update = nullptr);
+
+	// The scene of one frame, without rendering it.
+	AnimationFrame frame(int index, const Update& update = nullptr) const;
+
+private:
+	static RenderQueue& defaultQueue() {
+		static RenderQueue queue;
+		return queue;
+	}
+
+	RenderJob makeJob(const AnimationFrame& frame);
+
+	void renderIncremental(int first, int last, const Update& update);
+
+	// Starts saving a frame once the previous one is saved.
+	void save(int index, const shared_ptr<Matrix<uint8>>& image);
+
+	void finishSave();
+
+	int framesInFlight() const;
+
+private:
+	vector<shared_ptr<Geometry>> _geometries;
+	vector<shared_ptr<Light>> _lights;
+	PerspectiveCamera _camera;
+	Options _options;
+	RenderQueue& _queue;
+
+	std::map<shared_ptr<Sphere>, std::map<int, Vector3D>> _keyframes;
+
+	shared_ptr<BVH> _bvh;
+
+	std::future<void> _saving;
+	int _savingFrame;
+};
+
+
+template<typename T>
+shared_ptr<T> AnimationFrame::modify(const shared_ptr<T>& geometry) {
+	auto copy = _copies.find(geometry.get());
+
+	if (copy != _copies.end()) return std::static_pointer_cast<T>(copy->second);
+
+	for (auto& g : geometries) {
+		if (g == geometry) {
+			auto modified = std::make_shared<T>(*geometry);
+			g = modified;
+			_copies[geometry.get()] = modified;
+
+			return modified;
+		}
+	}
+
+	throw Exception("Geometry is not in the animation!");
+}
+
+
+AnimationRenderer::AnimationRenderer(const vector<shared_ptr<Geometry>>& geometries, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera,
+									 const Options& options, RenderQueue& queue)
+	: _geometries(geometries)
+	, _lights(lights)
+	, _camera(camera)
+	, _options(options)
+	, _queue(queue)
+	, _savingFrame(-1) {
+}
+
+void AnimationRenderer::addKeyframe(const shared_ptr<Sphere>& sphere, int frame, const Vector3D& center) {
+	_keyframes[sphere][frame] = center;
+}
+
+AnimationFrame AnimationRenderer::frame(int index, const Update& update) const {
+	AnimationFrame frame(index, _geometries, _lights, _camera);
+
+	for (auto& keys : _keyframes) {
+		const auto& centers = keys.second;
+		auto next = centers.lower_bound(index);
+		Vector3D center;
+
+		if (next == centers.end()) {
+			center = centers.rbegin()->second;
+		}
+		else if (next->first == index || next == centers.begin()) {
+			center = next->second;
+		}
+		else {
+			auto prev = std::prev(next);
+			const double t = double(index - prev->first) / (next->first - prev->first);
+			center = prev->second * (1 - t) + next->second * t;
+		}
+
+		frame.modify(keys.first)->setCenter(center);
+	}
+
+	if (update) update(frame);
+
+	return frame;
+}
+
+
+/*------------------------------------------------------------------------------------------/
+| function:    render
+| description:
+|              Render and save a range of frames.
+|
+| input:       @param first, last: frames [first, last).
+|              @param update: changes the scene of each frame, may be empty.
+|
+| return:      none; throws if a frame failed to render or save
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+void AnimationRenderer::render(int first, int last, const Update& update) {
+	if (_options.incremental && _options.method == RenderJob::RAY_TRACE) {
+		renderIncremental(first, last, update);
+		return;
+	}
+
+	const int window = framesInFlight();
+
+	std::deque<std::pair<int, std::future<Matrix<uint8>>>> rendering;
+	int next = first;
+
+	while (next < last || !rendering.empty()) {
+		while (next < last && (int)rendering.size() < window) {
+			rendering.emplace_back(next, _queue.submit(makeJob(frame(next, update))));
+			++next;
+		}
+
+		save(rendering.front().first, std::make_shared<Matrix<uint8>>(rendering.front().second.get()));
+		rendering.pop_front();
+	}
+
+	finishSave();
+}
+
+void AnimationRenderer::renderIncremental(int first, int last, const Update& update) {
+	IncrementalRayTracer tracer(_options.size, _options.maxReflect);
+
+	for (int index = first; index < last; ++index) {
+		const AnimationFrame f = frame(index, update);
+
+		save(index, std::make_shared<Matrix<uint8>>(tracer.render(f.geometries, f.lights, f.camera)));
+	}
+
+	finishSave();
+}
+
+void AnimationRenderer::save(int index, const shared_ptr<Matrix<uint8>>& image) {
+	// One frame is encoded while the next ones render; a second waits for it, so frames are
+	// written in order and at most two finished images are held.
+	finishSave();
+
+	const std::string filepath = String::format(_options.pattern.c_str(), index);
+
+	_saving = std::async(std::launch::async, [image, filepath]() { PXMImage::save(*image, filepath); });
+	_savingFrame = index;
+}
+
+void AnimationRenderer::finishSave() {
+	if (!_saving.valid()) return;
+
+	_saving.get();
+	if (_options.saved) _options.saved(_savingFrame);
+}
+
+RenderJob AnimationRenderer::makeJob(const AnimationFrame& frame) {
+	shared_ptr<const Geometry> scene;
+
+	if (_options.accelerate) {
+		_bvh = _bvh ? BVH::update(*_bvh, frame.geometries) : make_shared<BVH>(frame.geometries);
+		scene = _bvh;
+	}
+	else {
+		scene = make_shared<UnionGeometry>(frame.geometries);
+	}
+
+	RenderJob job = _options.method == RenderJob::PATH_TRACE ? RenderJob::pathTrace(scene, frame.camera, _options.samples, _options.size)
+				  : _options.method == RenderJob::RAY_TRACE ? RenderJob::rayTrace(scene, frame.lights, frame.camera, _options.maxReflect, _options.size)
+				  : RenderJob::renderLight(scene, frame.lights, frame.camera, _options.size);
+
+	job.priority = _options.priority;
+
+	return job;
+}
+
+int AnimationRenderer::framesInFlight() const {
+	if (_options.framesInFlight > 0) return _options.framesInFlight;
+
+	// Two frames keep the pool busy while one finishes; more when a frame has fewer rows than
+	// twice the threads.
+	const int rows = std::max(1, _options.size.height());
+
+	return 2 + (2 * _queue.pool().size() - 1) / rows;
+}
@@ -0,0 +1,661 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     BVH.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Bounding volume hierarchy over the geometries of a scene, for scenes that change.
+//
+//                A binary tree with one geometry per leaf, built top down with binned SAH. It then
+//                follows the scene without being built again:
+//
+//                  - insert() descends to the sibling of least SAH cost increase, remove() lifts
+//                    the sibling of the leaf into its parent;
+//                  - replace() puts a moved geometry in its old leaf, moved() follows one moved in
+//                    place; both refit the boxes above it, and refit() refits the whole tree in
+//                    O(N), bottom up. replace() inserts geometry that moved far from its leaf
+//                    again instead;
+//                  - the nodes on the path of every change are rotated, swapping a child with a
+//                    grandchild when that shrinks the surface area; optimize() rotates all nodes
+//                    and builds again once the SAH cost has grown past 'rebuildThreshold' times
+//                    the cost of the last build.
+//
+//                Geometry without bounds, such as planes, is kept out of the tree and tested by
+//                every ray.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Geometry.h"
+#include "AABB.h"
+#include "Profiler.h"
+#include "MyException.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using std::vector;
+using std::shared_ptr;
+
+class BVH : public Geometry {
+public:
+	explicit BVH(const vector<shared_ptr<Geometry>>& geometries = vector<shared_ptr<Geometry>>());
+
+	// The BVH of 'geometries' made from 'previous' by its changes alone. Geometries with the id of
+	// one that left, as copies made by AnimationFrame::modify have, take its leaf; the others are
+	// inserted and removed.
+	static shared_ptr<BVH> update(const BVH& previous, const vector<shared_ptr<Geometry>>& geometries);
+
+	virtual IntersectResult intersect(const Ray3D& ray) const;
+
+	virtual double calcDistance(const Ray3D& ray) const { throw Exception("Illegal function call: 'BVH' is an abstract class!"); }
+
+	virtual pair<Vector3D, Vector3D> calcPositionAndNormal(const Ray3D& ray, double distance) const { throw Exception("Illegal function call: 'BVH' is an abstract class!"); }
+
+	virtual AABB getBounds() const;
+
+	void insert(const shared_ptr<Geometry>& geometry);
+
+	void remove(const Geometry* geometry);
+
+	// 'geometry' in the leaf of 'old'.
+	void replace(const Geometry* old, const shared_ptr<Geometry>& geometry);
+
+	// After 'geometry' changed its bounds.
+	void moved(const Geometry* geometry);
+
+	// Boxes of all nodes from the bounds of their geometry.
+	void refit();
+
+	// Rotations over the whole tree, or a new build if they do not bring the cost under the
+	// threshold.
+	void optimize();
+
+	void rebuild();
+
+	// SAH cost of a ray through the root: expected nodes visited plus geometries tested.
+	double cost() const;
+
+	// Cost of the tree right after its last build.
+	double builtCost() const { return _builtCost; }
+
+	int size() const { return (int)_leaves.size() + (int)_unbounded.size(); }
+
+	vector<shared_ptr<Geometry>> getAll() const;
+
+	double rebuildThreshold = 1.3;
+
+private:
+	struct Node {
+		AABB bounds;
+		int parent;
+		int left, right;                 // -1 for a leaf
+		shared_ptr<Geometry> geometry;   // leaves only
+
+		bool isLeaf() const { return left < 0; }
+	};
+
+	int allocate();
+
+	void release(int node);
+
+	int build(vector<int>& leaves, int begin, int end, vector<Vector3D>& centers);
+
+	// Boxes from 'node' to the root, rotating each.
+	void refitUp(int node);
+
+	void updateBounds(int node) { _nodes[node].bounds = AABB(_nodes[_nodes[node].left].bounds).expand(_nodes[_nodes[node].right].bounds); }
+
+	void rotate(int node);
+
+	void swapChildren(int a, int b);
+
+	// Internal nodes, children before parents.
+	vector<int> postOrder() const;
+
+	int leafOf(const Geometry* geometry) const;
+
+private:
+	vector<Node> _nodes;
+	vector<int> _free;
+	int _root;
+
+	std::unordered_map<const Geometry*, int> _leaves;
+	vector<shared_ptr<Geometry>> _unbounded;
+
+	double _builtCost;
+};
+
+
+BVH::BVH(const vector<shared_ptr<Geometry>>& geometries)
+	: _root(-1)
+	, _builtCost(0) {
+	for (auto& geometry : geometries) {
+		if (!geometry->getBounds().isFinite()) {
+			_unbounded.push_back(geometry);
+			continue;
+		}
+
+		const int leaf = allocate();
+		_nodes[leaf].bounds = geometry->getBounds();
+		_nodes[leaf].geometry = geometry;
+		_leaves[geometry.get()] = leaf;
+	}
+
+	rebuild();
+}
+
+shared_ptr<BVH> BVH::update(const BVH& previous, const vector<shared_ptr<Geometry>>& geometries) {
+	auto bvh = std::make_shared<BVH>(previous);
+
+	std::unordered_set<const Geometry*> current;
+	for (auto& geometry : geometries) current.insert(geometry.get());
+
+	// Geometries that left, by id, so their copies can take their leaves.
+	std::unordered_map<int, const Geometry*> left;
+
+	for (auto& geometry : previous.getAll())
+		if (!current.count(geometry.get())) left[geometry->getId()] = geometry.get();
+
+	for (auto& geometry : geometries) {
+		if (previous._leaves.count(geometry.get())) continue;
+		if (std::find(previous._unbounded.begin(), previous._unbounded.end(), geometry) != previous._unbounded.end()) continue;
+
+		auto old = left.find(geometry->getId());
+
+		if (old != left.end() && previous._leaves.count(old->second) && geometry->getBounds().isFinite()) {
+			bvh->replace(old->second, geometry);
+			left.erase(old);
+		}
+		else {
+			bvh->insert(geometry);
+		}
+	}
+
+	for (auto& old : left)
+		bvh->remove(old.second);
+
+	if (bvh->cost() > bvh->rebuildThreshold * bvh->_builtCost) bvh->optimize();
+
+	return bvh;
+}
+
+
+IntersectResult BVH::intersect(const Ray3D& ray) const {
+	struct Entry {
+		int node;
+		double t;
+	};
+
+	thread_local vector<Entry> stack;
+	stack.clear();
+
+	double minDist = std::numeric_limits<double>::max();
+	const Geometry* nearest = nullptr;
+
+	Profiler::countIntersectionTests((int)_unbounded.size());
+
+	for (auto& geometry : _unbounded) {
+		const double dist = geometry->calcDistance(ray);
+
+		if (dist < minDist) {
+			minDist = dist;
+			nearest = geometry.get();
+		}
+	}
+
+	const Vector3D& o = ray.getOrigin();
+	const Vector3D& d = ray.getDirection();
+	const Vector3D inverse(1 / d.x(), 1 / d.y(), 1 / d.z());
+
+	if (_root >= 0) {
+		const double t = _nodes[_root].bounds.hit(o, inverse, minDist);
+		if (t < minDist) stack.push_back(Entry{ _root, t });
+	}
+
+	while (!stack.empty()) {
+		const Entry entry = stack.back();
+		stack.pop_back();
+
+		if (entry.t >= minDist) continue;
+
+		const Node& node = _nodes[entry.node];
+
+		if (node.isLeaf()) {
+			Profiler::countIntersectionTests(1);
+
+			const double dist = node.geometry->calcDistance(ray);
+
+			if (dist < minDist) {
+				minDist = dist;
+				nearest = node.geometry.get();
+			}
+
+			continue;
+		}
+
+		const double tl = _nodes[node.left].bounds.hit(o, inverse, minDist);
+		const double tr = _nodes[node.right].bounds.hit(o, inverse, minDist);
+
+		// The nearer child on top.
+		if (tl <= tr) {
+			if (tr < minDist) stack.push_back(Entry{ node.right, tr });
+			if (tl < minDist) stack.push_back(Entry{ node.left, tl });
+		}
+		else {
+			if (tl < minDist) stack.push_back(Entry{ node.left, tl });
+			if (tr < minDist) stack.push_back(Entry{ node.right, tr });
+		}
+	}
+
+	if (!nearest) return IntersectResult::noHit;
+
+	auto&& r = nearest->calcPositionAndNormal(ray, minDist);
+	return IntersectResult(nearest, minDist, r.first, r.second);
+}
+
+AABB BVH::getBounds() const {
+	if (!_unbounded.empty()) return AABB::infinite();
+
+	return _root >= 0 ? _nodes[_root].bounds : AABB();
+}
+
+
+void BVH::insert(const shared_ptr<Geometry>& geometry) {
+	if (_leaves.count(geometry.get())) throw Exception("Geometry is already in the BVH!");
+
+	const AABB box = geometry->getBounds();
+
+	if (!box.isFinite()) {
+		_unbounded.push_back(geometry);
+		return;
+	}
+
+	const int leaf = allocate();
+	_nodes[leaf].bounds = box;
+	_nodes[leaf].geometry = geometry;
+	_leaves[geometry.get()] = leaf;
+
+	if (_root < 0) {
+		_root = leaf;
+		return;
+	}
+
+	// Descend while a child takes the leaf for less than a new parent here would cost.
+	int sibling = _root;
+
+	while (!_nodes[sibling].isLeaf()) {
+		const Node& node = _nodes[sibling];
+		const double area = node.bounds.surfaceArea();
+		const double combined = AABB(node.bounds).expand(box).surfaceArea();
+
+		// A new parent here costs twice its area; below, the nodes on the way grow too.
+		const double here = 2 * combined;
+		const double inherited = 2 * (combined - area);
+
+		auto descend = [&](int child) {
+			const double grown = AABB(_nodes[child].bounds).expand(box).surfaceArea();
+			return _nodes[child].isLeaf() ? grown + inherited : grown - _nodes[child].bounds.surfaceArea() + inherited;
+		};
+
+		const double left = descend(node.left), right = descend(node.right);
+
+		if (here < left && here < right) break;
+
+		sibling = left < right ? node.left : node.right;
+	}
+
+	const int oldParent = _nodes[sibling].parent;
+	const int parent = allocate();
+
+	_nodes[parent].parent = oldParent;
+	_nodes[parent].left = sibling;
+	_nodes[parent].right = leaf;
+	_nodes[sibling].parent = parent;
+	_nodes[leaf].parent = parent;
+
+	if (oldParent < 0) _root = parent;
+	else if (_nodes[oldParent].left == sibling) _nodes[oldParent].left = parent;
+	else _nodes[oldParent].right = parent;
+
+	refitUp(parent);
+}
+
+void BVH::remove(const Geometry* geometry) {
+	auto unbounded = std::find_if(_unbounded.begin(), _unbounded.end(), [&](const shared_ptr<Geometry>& g) { return g.get() == geometry; });
+
+	if (unbounded != _unbounded.end()) {
+		_unbounded.erase(unbounded);
+		return;
+	}
+
+	const int leaf = leafOf(geometry);
+	const int parent = _nodes[leaf].parent;
+
+	_leaves.erase(geometry);
+	release(leaf);
+
+	if (parent < 0) {
+		_root = -1;
+		return;
+	}
+
+	const int sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+	const int grandparent = _nodes[parent].parent;
+
+	_nodes[sibling].parent = grandparent;
+	release(parent);
+
+	if (grandparent < 0) {
+		_root = sibling;
+		return;
+	}
+
+	if (_nodes[grandparent].left == parent) _nodes[grandparent].left = sibling;
+	else _nodes[grandparent].right = sibling;
+
+	refitUp(grandparent);
+}
+
+void BVH::replace(const Geometry* old, const shared_ptr<Geometry>& geometry) {
+	const int leaf = leafOf(old);
+	const int parent = _nodes[leaf].parent;
+	const AABB box = geometry->getBounds();
+
+	// Refitting is for small moves; one that more than doubles the area of the parent would
+	// stretch every box above it, so the geometry finds a new place instead.
+	bool far = !box.isFinite();
+
+	if (!far && parent >= 0) {
+		const int sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+		far = AABB(_nodes[sibling].bounds).expand(box).surfaceArea() > 2 * _nodes[parent].bounds.surfaceArea();
+	}
+
+	if (far) {
+		remove(old);
+		insert(geometry);
+		return;
+	}
+
+	_leaves.erase(old);
+	_leaves[geometry.get()] = leaf;
+	_nodes[leaf].geometry = geometry;
+
+	moved(geometry.get());
+}
+
+void BVH::moved(const Geometry* geometry) {
+	const int leaf = leafOf(geometry);
+
+	_nodes[leaf].bounds = geometry->getBounds();
+
+	if (_nodes[leaf].parent >= 0) refitUp(_nodes[leaf].parent);
+}
+
+void BVH::refit() {
+	for (auto& leaf : _leaves)
+		_nodes[leaf.second].bounds = leaf.first->getBounds();
+
+	for (int node : postOrder())
+		updateBounds(node);
+}
+
+void BVH::optimize() {
+	for (int node : postOrder()) {
+		updateBounds(node);
+		rotate(node);
+	}
+
+	if (cost() > rebuildThreshold * _builtCost) rebuild();
+}
+
+
+/*------------------------------------------------------------------------------------------/
+| function:    rebuild
+| description:
+|              Build the tree again from its leaves, top down, splitting where binned SAH is least.
+|
+| input:       none
+|
+| return:      none
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+void BVH::rebuild() {
+	vector<int> leaves;
+	leaves.reserve(_leaves.size());
+
+	for (auto& leaf : _leaves)
+		leaves.push_back(leaf.second);
+
+	// Internal nodes are all made again.
+	for (int node : postOrder())
+		release(node);
+
+	vector<Vector3D> centers(_nodes.size());
+	for (int leaf : leaves) centers[leaf] = _nodes[leaf].bounds.center();
+
+	// Map order depends on addresses; sort so the same scene gives the same tree.
+	std::sort(leaves.begin(), leaves.end());
+
+	_root = leaves.empty() ? -1 : build(leaves, 0, (int)leaves.size(), centers);
+
+	if (_root >= 0) _nodes[_root].parent = -1;
+
+	_builtCost = cost();
+}
+
+int BVH::build(vector<int>& leaves, int begin, int end, vector<Vector3D>& centers) {
+	if (end - begin == 1) return leaves[begin];
+
+	AABB bounds, centroids;
+
+	for (int i = begin; i < end; ++i) {
+		bounds.expand(_nodes[leaves[i]].bounds);
+		centroids.expand(centers[leaves[i]]);
+	}
+
+	const Vector3D extent = centroids.getMax() - centroids.getMin();
+	const int axis = extent.x() >= extent.y() && extent.x() >= extent.z() ? 0 : extent.y() >= extent.z() ? 1 : 2;
+	const double lo = centroids.getMin()[axis], width = extent[axis];
+
+	int mid = (begin + end) / 2;
+
+	if (width > 0) {
+		const int binCount = 16;
+		AABB binBounds[binCount];
+		int binSizes[binCount] = { 0 };
+
+		auto binOf = [&](int leaf) { return std::min(binCount - 1, int((centers[leaf][axis] - lo) / width * binCount)); };
+
+		for (int i = begin; i < end; ++i) {
+			const int bin = binOf(leaves[i]);
+			binBounds[bin].expand(_nodes[leaves[i]].bounds);
+			++binSizes[bin];
+		}
+
+		// Cost of splitting after bin k: area times count, left and right.
+		double leftCost[binCount];
+		AABB box;
+		int count = 0;
+
+		for (int k = 0; k < binCount - 1; ++k) {
+			box.expand(binBounds[k]);
+			count += binSizes[k];
+			leftCost[k] = box.surfaceArea() * count;
+		}
+
+		box = AABB();
+		count = 0;
+
+		double bestCost = std::numeric_limits<double>::max();
+		int bestSplit = -1;
+
+		for (int k = binCount - 1; k > 0; --k) {
+			box.expand(binBounds[k]);
+			count += binSizes[k];
+
+			const double cost = leftCost[k - 1] + box.surfaceArea() * count;
+
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestSplit = k;
+			}
+		}
+
+		mid = (int)(std::partition(leaves.begin() + begin, leaves.begin() + end, [&](int leaf) { return binOf(leaf) < bestSplit; }) - leaves.begin());
+
+		if (mid == begin || mid == end) mid = (begin + end) / 2;
+	}
+
+	const int node = allocate();
+	const int left = build(leaves, begin, mid, centers);
+	const int right = build(leaves, mid, end, centers);
+
+	_nodes[node].left = left;
+	_nodes[node].right = right;
+	_nodes[node].bounds = bounds;
+	_nodes[left].parent = node;
+	_nodes[right].parent = node;
+
+	return node;
+}
+
+double BVH::cost() const {
+	if (_root < 0) return (double)_unbounded.size();
+
+	double area = 0;
+
+	for (const Node& node : _nodes)
+		if (node.parent >= 0 || &node == &_nodes[_root]) area += node.bounds.surfaceArea();
+
+	const double rootArea = _nodes[_root].bounds.surfaceArea();
+
+	return _unbounded.size() + (rootArea > 0 ? area / rootArea : (double)_leaves.size());
+}
+
+vector<shared_ptr<Geometry>> BVH::getAll() const {
+	vector<shared_ptr<Geometry>> geometries(_unbounded);
+
+	for (auto& leaf : _leaves)
+		geometries.push_back(_nodes[leaf.second].geometry);
+
+	return geometries;
+}
+
+
+int BVH::allocate() {
+	if (_free.empty()) {
+		_nodes.push_back(Node{ AABB(), -1, -1, -1, nullptr });
+		return (int)_nodes.size() - 1;
+	}
+
+	const int node = _free.back();
+	_free.pop_back();
+
+	_nodes[node] = Node{ AABB(), -1, -1, -1, nullptr };
+
+	return node;
+}
+
+void BVH::release(int node) {
+	// Released nodes look like detached, empty leaves, so cost() skips them.
+	_nodes[node] = Node{ AABB(), -1, -1, -1, nullptr };
+	_free.push_back(node);
+}
+
+void BVH::refitUp(int node) {
+	for (; node >= 0; node = _nodes[node].parent) {
+		updateBounds(node);
+		rotate(node);
+	}
+}
+
+void BVH::rotate(int node) {
+	const Node& n = _nodes[node];
+	const int l = n.left, r = n.right;
+
+	// The child a grandchild on the other side would be swapped with, and the area its new
+	// parent would have.
+	int bestA = -1, bestB = -1;
+	double bestGain = 0;
+
+	auto consider = [&](int child, int grandchild, int other) {
+		// 'child' trades places with 'grandchild', a child of 'other'.
+		const Node& o = _nodes[other];
+		const int kept = o.left == grandchild ? o.right : o.left;
+		const double area = AABB(_nodes[child].bounds).expand(_nodes[kept].bounds).surfaceArea();
+		const double gain = o.bounds.surfaceArea() - area;
+
+		if (gain > bestGain) {
+			bestGain = gain;
+			bestA = child;
+			bestB = grandchild;
+		}
+	};
+
+	if (!_nodes[r].isLeaf()) {
+		consider(l, _nodes[r].left, r);
+		consider(l, _nodes[r].right, r);
+	}
+
+	if (!_nodes[l].isLeaf()) {
+		consider(r, _nodes[l].left, l);
+		consider(r, _nodes[l].right, l);
+	}
+
+	if (bestA >= 0) swapChildren(bestA, bestB);
+}
+
+void BVH::swapChildren(int a, int b) {
+	// 'a' is a child of the grandparent of 'b'; they trade parents.
+	const int pa = _nodes[a].parent, pb = _nodes[b].parent;
+
+	if (_nodes[pa].left == a) _nodes[pa].left = b;
+	else _nodes[pa].right = b;
+
+	if (_nodes[pb].left == b) _nodes[pb].left = a;
+	else _nodes[pb].right = a;
+
+	_nodes[a].parent = pb;
+	_nodes[b].parent = pa;
+
+	updateBounds(pb);
+}
+
+vector<int> BVH::postOrder() const {
+	vector<int> order, stack;
+
+	if (_root >= 0) stack.push_back(_root);
+
+	while (!stack.empty()) {
+		const int node = stack.back();
+		stack.pop_back();
+
+		if (_nodes[node].isLeaf()) continue;
+
+		order.push_back(node);
+		stack.push_back(_nodes[node].left);
+		stack.push_back(_nodes[node].right);
+	}
+
+	std::reverse(order.begin(), order.end());
+
+	return order;
+}
+
+int BVH::leafOf(const Geometry* geometry) const {
+	auto leaf = _leaves.find(geometry);
+
+	if (leaf == _leaves.end()) throw Exception("Geometry is not in the BVH!");
+
+	return leaf->second;
+}
@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     CachedTexture.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Image texture read through a TextureCache, with trilinear filtering.
+//
+//                The image is never loaded whole. Filtering uses the mip chain of each tile, so
+//                footprints wider than a tile are clamped to the coarsest level of the tile.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Texture.h"
+#include "TextureCache.h"
+#include "MyMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+class CachedTexture : public Texture {
+public:
+
+	CachedTexture(const std::shared_ptr<TextureCache>& cache, const string& filepath)
+		: _cache(cache)
+		, _texture(cache->add(filepath)) {
+		const Size size = cache->size(_texture);
+
+		_height = size.height();
+		_width = size.width();
+		_tilesX = (_width + cache->tileSize() - 1) >> cache->tileBits();
+	}
+
+	virtual Color lookup(double u, double v, double width) const;
+
+private:
+	Color bilinear(int level, double u, double v) const;
+
+	void texel(int level, int x, int y, uint8 rgb[3]) const;
+
+private:
+	std::shared_ptr<TextureCache> _cache;
+	int _texture;
+	int _height, _width, _tilesX;
+};
+
+
+Color CachedTexture::lookup(double u, double v, double width) const {
+	const double lod = Math::clip(std::log2(std::max(width*std::max(_width, _height), 1e-9)), 0.0, (double)_cache->tileBits());
+	const int lo = (int)lod;
+	const double t = lod - lo;
+
+	const Color c = bilinear(lo, u, v);
+
+	if (t == 0) return c;
+
+	return c*(1 - t) + bilinear(lo + 1, u, v)*t;
+}
+
+Color CachedTexture::bilinear(int level, double u, double v) const {
+	const double x = std::ldexp(u*_width, -level) - 0.5;
+	const double y = std::ldexp(v*_height, -level) - 0.5;
+	const double fx = std::floor(x), fy = std::floor(y);
+	const double ax = x - fx, ay = y - fy;
+	const int x0 = (int)fx, y0 = (int)fy;
+
+	uint8 p00[3], p01[3], p10[3], p11[3];
+
+	texel(level, x0, y0, p00);
+	texel(level, x0 + 1, y0, p01);
+	texel(level, x0, y0 + 1, p10);
+	texel(level, x0 + 1, y0 + 1, p11);
+
+	double rgb[3];
+
+	for (int k = 0; k < 3; ++k) {
+		const double top = p00[k] + (p01[k] - p00[k])*ax;
+		const double bottom = p10[k] + (p11[k] - p10[k])*ax;
+
+		rgb[k] = (top + (bottom - top)*ay) / 255;
+	}
+
+	return Color(rgb[0], rgb[1], rgb[2]);
+}
+
+void CachedTexture::texel(int level, int x, int y, uint8 rgb[3]) const {
+	// Size of the level, rounded up: the last tiles of a row or column may be partly padding.
+	const int width = ((_width - 1) >> level) + 1;
+	const int height = ((_height - 1) >> level) + 1;
+	const int size = _cache->tileSize() >> level;
+
+	// wrap around
+	x %= width;
+	y %= height;
+	if (x < 0) x += width;
+	if (y < 0) y += height;
+
+	_cache->texel(_texture, (y / size)*_tilesX + x / size, level, x % size, y % size, rgb);
+}
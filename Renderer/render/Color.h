@@ -16,6 +16,8 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+uint8 convert(double channel, double alpha = 1.0);
+
 struct Color {
 	static const Color BLACK;
 
@@ -46,7 +48,7 @@ struct Color {
 	// Modulate
 	Color modulate(const Color& rhs) const;
 
-	friend uint8 convert(double channel, double alpha = 1.0);
+	friend uint8 convert(double channel, double alpha);
 
 	double r, g, b;
 };
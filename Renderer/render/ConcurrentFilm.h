@@ -0,0 +1,313 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     ConcurrentFilm.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Film that takes samples anywhere in the image from any thread.
+//
+//                The image is stored as tiles of TILE x TILE pixels, allocated by the first samples
+//                that reach them. Every thread splats into a small cache of tiles of its own, so
+//                adding a sample takes neither a lock nor an atomic operation, and adds a cached
+//                tile to the film under the lock of that tile when it evicts it. The film thus holds
+//                one image, plus CACHED tiles per thread, whatever the number of threads.
+//
+//                Samples must not be added while linear(), image() or clear() run.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Filter.h"
+#include "Color.h"
+#include "Matrix.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class ConcurrentFilm {
+public:
+
+	ConcurrentFilm(int height, int width, const std::shared_ptr<Filter>& filter);
+
+	int height() const { return _height; }
+
+	int width() const { return _width; }
+
+	const FilterTable& getFilterTable() const { return _table; }
+
+	// Sample at (x, y) in pixels, anywhere in the image.
+	void addSample(double x, double y, const Color& radiance);
+
+	void clear();
+
+	// The weighted mean of every pixel, 3 channels.
+	Matrix<float> linear() const;
+
+	Matrix<uint8> image() const;
+
+	// Number of threads that have added samples.
+	int threads() const;
+
+private:
+	// A splat no wider than a tile spans at most 2x2 tiles, which take different slots of
+	// the cache of a thread.
+	enum { TILE = 32, CACHED = 8 };
+
+	// Weighted sums of r, g, b, and the sum of weights, of a tile. Not pooled: blocks are
+	// freed by whichever thread destroys the film.
+	typedef Matrix<float, AlignedAllocator> Block;
+
+	struct Tile {
+		std::mutex mutex;
+		Block sum;  // empty until samples reach the tile
+	};
+
+	// The tiles a thread splats into, direct mapped by slot().
+	struct Writer {
+		int tile[CACHED];           // -1 for none
+		int top[CACHED];            // rows of the block that hold samples, [top, bottom)
+		int bottom[CACHED];
+		Block block[CACHED];
+
+		Writer();
+	};
+
+	// The writer of the calling thread, for the film it used last.
+	struct LocalWriter {
+		uint64_t owner = 0;
+		Writer* writer = nullptr;
+	};
+
+	static uint64_t nextId() {
+		static std::atomic<uint64_t> id(0);
+		return ++id;
+	}
+
+	static int slot(int ty, int tx) { return (ty * 3 + tx) & (CACHED - 1); }
+
+	Writer& localWriter();
+
+	// Adds the block of slot k to its tile, and empties the slot.
+	void evict(Writer& writer, int k);
+
+	// Row i of the block of tile column tx in the cache of the writer, which takes the tile if
+	// it does not hold it yet.
+	float* row(Writer& writer, int i, int tx);
+
+private:
+	const uint64_t _id;
+	int _height, _width;
+	int _tilesY, _tilesX;
+	FilterTable _table;
+
+	std::unique_ptr<Tile[]> _tiles;
+
+	mutable std::mutex _mutex;
+	std::deque<Writer> _writers;  // a deque keeps them in place as it grows
+	std::unordered_map<std::thread::id, Writer*> _writerOf;
+};
+
+
+ConcurrentFilm::Writer::Writer() {
+	for (int k = 0; k < CACHED; ++k) {
+		tile[k] = -1;
+		top[k] = TILE;
+		bottom[k] = 0;
+		block[k].create(TILE, TILE, 4);
+	}
+}
+
+ConcurrentFilm::ConcurrentFilm(int height, int width, const std::shared_ptr<Filter>& filter)
+	: _id(nextId())
+	, _height(height)
+	, _width(width)
+	, _tilesY((height + TILE - 1) / TILE)
+	, _tilesX((width + TILE - 1) / TILE)
+	, _table(filter)
+	, _tiles(new Tile[_tilesY * _tilesX])
+{}
+
+ConcurrentFilm::Writer& ConcurrentFilm::localWriter() {
+	static thread_local LocalWriter local;
+
+	if (local.owner == _id) return *local.writer;
+
+	// First sample of this thread since it last used another film.
+	std::lock_guard<std::mutex> lock(_mutex);
+	Writer*& writer = _writerOf[std::this_thread::get_id()];
+
+	if (writer == nullptr) {
+		_writers.emplace_back();
+		writer = &_writers.back();
+	}
+
+	local.owner = _id;
+	local.writer = writer;
+
+	return *writer;
+}
+
+void ConcurrentFilm::evict(Writer& writer, int k) {
+	if (writer.tile[k] < 0) return;
+
+	Block& block = writer.block[k];
+	const int top = writer.top[k], bottom = writer.bottom[k];
+
+	if (top < bottom) {
+		Tile& tile = _tiles[writer.tile[k]];
+		std::lock_guard<std::mutex> lock(tile.mutex);
+
+		if (tile.sum.empty()) tile.sum.create(TILE, TILE, 4);
+
+		float* dst = &tile.sum(top, 0);
+		float* src = &block(top, 0);
+		const int n = (bottom - top) * TILE * 4;
+
+		for (int x = 0; x < n; ++x) {
+			dst[x] += src[x];
+			src[x] = 0;
+		}
+	}
+
+	writer.tile[k] = -1;
+	writer.top[k] = TILE;
+	writer.bottom[k] = 0;
+}
+
+float* ConcurrentFilm::row(Writer& writer, int i, int tx) {
+	const int ty = i / TILE;
+	const int t = ty * _tilesX + tx;
+	const int k = slot(ty, tx);
+
+	if (writer.tile[k] != t) {
+		evict(writer, k);
+		writer.tile[k] = t;
+	}
+
+	const int r = i % TILE;
+	writer.top[k] = std::min(writer.top[k], r);
+	writer.bottom[k] = std::max(writer.bottom[k], r + 1);
+
+	return &writer.block[k](r, 0);
+}
+
+void ConcurrentFilm::addSample(double x, double y, const Color& radiance) {
+	Writer& writer = localWriter();
+
+	// The row of a tile the last pixel fell in.
+	int lastI = -1, lastTx = -1;
+	float* r = nullptr;
+
+	_table.splat(x, y, 0, 0, _height, _width, [&](int i, int j, double w) {
+		const int tx = j / TILE;
+
+		if (i != lastI || tx != lastTx) {
+			r = row(writer, i, tx);
+			lastI = i;
+			lastTx = tx;
+		}
+
+		float* p = r + j % TILE * 4;
+
+		p[0] += (float)(radiance.r * w);
+		p[1] += (float)(radiance.g * w);
+		p[2] += (float)(radiance.b * w);
+		p[3] += (float)w;
+	});
+}
+
+void ConcurrentFilm::clear() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	for (int t = 0; t < _tilesY * _tilesX; ++t)
+		if (!_tiles[t].sum.empty()) _tiles[t].sum.create(TILE, TILE, 4);
+
+	for (auto& writer : _writers) {
+		for (int k = 0; k < CACHED; ++k) {
+			writer.tile[k] = -1;
+			writer.top[k] = TILE;
+			writer.bottom[k] = 0;
+			writer.block[k].create(TILE, TILE, 4);
+		}
+	}
+}
+
+int ConcurrentFilm::threads() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return (int)_writers.size();
+}
+
+Matrix<float> ConcurrentFilm::linear() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	const int tiles = _tilesY * _tilesX;
+
+	// The blocks still cached by the threads, by tile.
+	std::vector<std::vector<const Block*>> cached(tiles);
+
+	for (auto& writer : _writers)
+		for (int k = 0; k < CACHED; ++k)
+			if (writer.tile[k] >= 0) cached[writer.tile[k]].push_back(&writer.block[k]);
+
+	Matrix<float> m;
+	m.create(_height, _width, 3, false);
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for (int t = 0; t < tiles; ++t) {
+		const int top = t / _tilesX * TILE, left = t % _tilesX * TILE;
+		const int rows = std::min(_height - top, (int)TILE), cols = std::min(_width - left, (int)TILE);
+		std::vector<double> sum(TILE * TILE * 4, 0.0);
+
+		if (!_tiles[t].sum.empty()) {
+			const float* src = _tiles[t].sum.data();
+
+			for (int x = 0; x < TILE * TILE * 4; ++x)
+				sum[x] += src[x];
+		}
+
+		for (const Block* block : cached[t]) {
+			const float* src = block->data();
+
+			for (int x = 0; x < TILE * TILE * 4; ++x)
+				sum[x] += src[x];
+		}
+
+		for (int i = 0; i < rows; ++i) {
+			for (int j = 0; j < cols; ++j) {
+				const double* p = &sum[(i * TILE + j) * 4];
+
+				// Filters with negative lobes may leave a pixel without any net weight.
+				const double inv = p[3] != 0 ? 1 / p[3] : 0;
+
+				for (int k = 0; k < 3; ++k)
+					m(top + i, left + j, k) = (float)(p[k] * inv);
+			}
+		}
+	}
+
+	return m;
+}
+
+Matrix<uint8> ConcurrentFilm::image() const {
+	const Matrix<float> m = linear();
+	Matrix<uint8> result;
+	result.create(_height, _width, 3, false);
+
+	for (int i = 0; i < m.length(); ++i)
+		result.data()[i] = convert(m.data()[i]);
+
+	return result;
+}
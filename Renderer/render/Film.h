@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     Film.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Image plane that reconstructs pixels from samples at arbitrary positions.
+//
+//                Every sample is splatted into all pixels within the radius of a Filter, weighed
+//                by a FilterTable, and each pixel is the weighted mean of its samples. Sample
+//                positions are in pixels: x to the right, y down, pixel (i, j) covering
+//                [j, j + 1) x [i, i + 1).
+//
+//                Threads render into FilmTiles of their own, which also cover the border that the
+//                filter reaches into neighbouring tiles, and merge them into the Film when done;
+//                only the merge takes a lock.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Filter.h"
+#include "Color.h"
+#include "Matrix.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+class Film;
+
+class FilmTile {
+public:
+
+	// Sample at (x, y) in pixels of the film, which must lie in the region of the tile.
+	void addSample(double x, double y, const Color& radiance);
+
+private:
+	friend class Film;
+
+	FilmTile(const Film* film, int top, int left, int height, int width);
+
+	const Film* _film;
+	int _top, _left;        // of the buffer, in pixels of the film
+	Matrix<double> _pixels; // weighted sums of r, g, b, and the sum of weights
+};
+
+
+class Film {
+public:
+
+	Film(int height, int width, const std::shared_ptr<Filter>& filter);
+
+	int height() const { return _height; }
+
+	int width() const { return _width; }
+
+	const FilterTable& getFilterTable() const { return _table; }
+
+	// A tile for the samples in rows [top, top + height) and columns [left, left + width).
+	FilmTile makeTile(int top, int left, int height, int width) const;
+
+	void mergeTile(const FilmTile& tile);
+
+	void clear();
+
+	// The weighted mean of every pixel, 3 channels.
+	Matrix<float> linear() const;
+
+	Matrix<uint8> image() const;
+
+private:
+	int _height, _width;
+	FilterTable _table;
+
+	std::mutex _mutex;
+	Matrix<double> _pixels;
+};
+
+
+FilmTile::FilmTile(const Film* film, int top, int left, int height, int width)
+	: _film(film)
+	, _top(top)
+	, _left(left) {
+	_pixels.create(height, width, 4);
+}
+
+void FilmTile::addSample(double x, double y, const Color& radiance) {
+	_film->getFilterTable().splat(x, y, _top, _left, _top + _pixels.height(), _left + _pixels.width(), [&](int i, int j, double w) {
+		double* p = &_pixels(i - _top, j - _left);
+
+		p[0] += radiance.r * w;
+		p[1] += radiance.g * w;
+		p[2] += radiance.b * w;
+		p[3] += w;
+	});
+}
+
+
+Film::Film(int height, int width, const std::shared_ptr<Filter>& filter)
+	: _height(height)
+	, _width(width)
+	, _table(filter) {
+	_pixels.create(height, width, 4);
+}
+
+FilmTile Film::makeTile(int top, int left, int height, int width) const {
+	// Pixels whose centres lie within the radius of a sample in the region.
+	const int margin = (int)std::ceil(_table.getRadius() + 0.5);
+	const int y0 = std::max(top - margin, 0);
+	const int x0 = std::max(left - margin, 0);
+	const int y1 = std::min(top + height + margin, _height);
+	const int x1 = std::min(left + width + margin, _width);
+
+	return FilmTile(this, y0, x0, y1 - y0, x1 - x0);
+}
+
+void Film::mergeTile(const FilmTile& tile) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	const int rowLength = tile._pixels.width() * 4;
+
+	for (int i = 0; i < tile._pixels.height(); ++i) {
+		const double* src = &tile._pixels(i, 0);
+		double* dst = &_pixels(tile._top + i, tile._left);
+
+		for (int x = 0; x < rowLength; ++x)
+			dst[x] += src[x];
+	}
+}
+
+void Film::clear() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_pixels.create(_height, _width, 4);
+}
+
+Matrix<float> Film::linear() const {
+	Matrix<float> m;
+	m.create(_height, _width, 3, false);
+
+	for (int i = 0; i < _height; ++i) {
+		for (int j = 0; j < _width; ++j) {
+			const double* p = &_pixels(i, j);
+
+			// Filters with negative lobes may leave a pixel without any net weight.
+			const double inv = p[3] != 0 ? 1 / p[3] : 0;
+
+			for (int k = 0; k < 3; ++k)
+				m(i, j, k) = (float)(p[k] * inv);
+		}
+	}
+
+	return m;
+}
+
+Matrix<uint8> Film::image() const {
+	const Matrix<float> m = linear();
+	Matrix<uint8> result;
+	result.create(_height, _width, 3, false);
+
+	for (int i = 0; i < m.length(); ++i)
+		result.data()[i] = convert(m.data()[i]);
+
+	return result;
+}
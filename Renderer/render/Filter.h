@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     Filter.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Pixel reconstruction filters: box, tent, Gaussian and Mitchell-Netravali.
+//
+//                A filter weighs a sample by its offset (x, y) in pixels from a pixel centre, and is
+//                zero beyond 'radius' along either axis. All of them are separable.
+//
+//                FilterTable samples a filter once so that splatting a sample costs a table lookup
+//                per pixel instead of a call to evaluate().
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+class Filter {
+public:
+
+	explicit Filter(double radius) : _radius(radius) { assert(radius > 0); }
+
+	virtual ~Filter(){}
+
+	virtual double evaluate(double x, double y) const = 0;
+
+	double getRadius() const { return _radius; }
+
+protected:
+	double _radius;
+};
+
+
+class BoxFilter : public Filter {
+public:
+
+	explicit BoxFilter(double radius = 0.5) : Filter(radius) {}
+
+	virtual double evaluate(double x, double y) const { return 1; }
+};
+
+
+class TentFilter : public Filter {
+public:
+
+	explicit TentFilter(double radius = 1) : Filter(radius) {}
+
+	virtual double evaluate(double x, double y) const {
+		return std::max(0.0, _radius - std::abs(x)) * std::max(0.0, _radius - std::abs(y));
+	}
+};
+
+
+class GaussianFilter : public Filter {
+public:
+
+	// exp(-alpha*x^2), shifted down to reach zero at the radius.
+	explicit GaussianFilter(double radius = 1.5, double alpha = 2)
+		: Filter(radius)
+		, _alpha(alpha)
+		, _edge(std::exp(-alpha * radius * radius))
+	{}
+
+	virtual double evaluate(double x, double y) const { return gaussian(x) * gaussian(y); }
+
+private:
+	double gaussian(double x) const { return std::max(0.0, std::exp(-_alpha * x * x) - _edge); }
+
+	double _alpha, _edge;
+};
+
+
+class MitchellFilter : public Filter {
+public:
+
+	// B = C = 1/3 is the compromise between blurring and ringing recommended by Mitchell and Netravali.
+	explicit MitchellFilter(double radius = 2, double B = 1. / 3, double C = 1. / 3)
+		: Filter(radius)
+		, _B(B)
+		, _C(C)
+	{}
+
+	virtual double evaluate(double x, double y) const { return mitchell(x / _radius) * mitchell(y / _radius); }
+
+private:
+	// The cubic on [-2, 2], with x given in [-1, 1].
+	double mitchell(double x) const {
+		x = std::abs(2 * x);
+
+		if (x > 2) return 0;
+
+		if (x > 1)
+			return ((-_B - 6 * _C) * x*x*x + (6 * _B + 30 * _C) * x*x + (-12 * _B - 48 * _C) * x + (8 * _B + 24 * _C)) / 6;
+		else
+			return ((12 - 9 * _B - 6 * _C) * x*x*x + (-18 + 12 * _B + 6 * _C) * x*x + (6 - 2 * _B)) / 6;
+	}
+
+	double _B, _C;
+};
+
+
+class FilterTable {
+public:
+
+	// Entries along each axis.
+	static const int tableSize = 16;
+
+	explicit FilterTable(const std::shared_ptr<Filter>& filter)
+		: _filter(filter)
+		, _table(tableSize * tableSize)
+		, _scale(tableSize / filter->getRadius()) {
+		// Each entry holds the filter at the centre of its cell; filters are symmetric, so one quadrant will do.
+		for (int i = 0; i < tableSize; ++i)
+			for (int j = 0; j < tableSize; ++j)
+				_table[i * tableSize + j] = filter->evaluate((j + 0.5) / _scale, (i + 0.5) / _scale);
+	}
+
+	const Filter& getFilter() const { return *_filter; }
+
+	double getRadius() const { return _filter->getRadius(); }
+
+	// Weight of a sample at offset (dx, dy) from a pixel centre, within the radius.
+	double operator() (double dx, double dy) const {
+		const int ix = std::min((int)(std::abs(dx) * _scale), tableSize - 1);
+		const int iy = std::min((int)(std::abs(dy) * _scale), tableSize - 1);
+
+		return _table[iy * tableSize + ix];
+	}
+
+	// Calls f(i, j, weight) for every pixel (i, j) in rows [top, bottom) and columns [left, right)
+	// that a sample at (x, y) reaches. Positions are in pixels, pixel (i, j) covering [j, j + 1) x [i, i + 1).
+	template<typename F>
+	void splat(double x, double y, int top, int left, int bottom, int right, F f) const {
+		const double radius = getRadius();
+
+		// relative to pixel centres
+		x -= 0.5;
+		y -= 0.5;
+
+		const int x0 = std::max((int)std::ceil(x - radius), left);
+		const int x1 = std::min((int)std::floor(x + radius), right - 1);
+		const int y0 = std::max((int)std::ceil(y - radius), top);
+		const int y1 = std::min((int)std::floor(y + radius), bottom - 1);
+
+		for (int i = y0; i <= y1; ++i)
+			for (int j = x0; j <= x1; ++j)
+				f(i, j, (*this)(j - x, i - y));
+	}
+
+private:
+	std::shared_ptr<Filter> _filter;
+	std::vector<double> _table;
+	double _scale;
+};
@@ -0,0 +1,690 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     FlatBVH.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Bounding volume hierarchy of a static scene, built in parallel into one flat array.
+//
+//                The geometries are first sorted along a Morton curve of their centers by a parallel
+//                radix sort. The tree is then built top down by one of two methods:
+//
+//                  SAH:   the split of least surface area heuristic over 32 bins along the widest
+//                         axis of the centers;
+//                  LBVH:  the split at the highest bit in which the Morton codes of a range differ,
+//                         found by binary search, several times faster to build.
+//
+//                Ranges too large to be split by one thread are split one after the other, each
+//                binned by all threads; the many smaller ranges left are then built by one thread
+//                each. Splits that fail, such as a range of equal centers, fall back to the middle
+//                of the range, which the Morton order keeps spatially coherent.
+//
+//                Nodes are 32 bytes and come from one pool, allocated up front by AlignedAllocator.
+//                The two children of a node are allocated together, at an even index, so a cache
+//                line holds both; the root is node 0 and node 1 is padding. A leaf holds a range of
+//                the geometries in tree order.
+//
+//                Geometry without bounds, such as planes, is kept out of the tree and tested by
+//                every ray.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Geometry.h"
+#include "AABB.h"
+#include "Allocator.h"
+#include "Profiler.h"
+#include "MyException.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using std::vector;
+using std::shared_ptr;
+
+class FlatBVH : public Geometry {
+public:
+	enum Method { SAH, LBVH };
+
+	struct Node {
+		float min[3];
+		int offset;     // internal: the left child, the right one at offset + 1; leaf: the first geometry
+		float max[3];
+		int count;      // leaf: geometries; internal: 0
+
+		bool isLeaf() const { return count > 0; }
+	};
+
+	FlatBVH(const vector<shared_ptr<Geometry>>& geometries, Method method = SAH, int maxLeafSize = 4);
+
+	~FlatBVH() { if (_nodes) AlignedAllocator::deallocate(_nodes, _capacity * sizeof(Node)); }
+
+	FlatBVH(const FlatBVH&) = delete;
+
+	FlatBVH& operator = (const FlatBVH&) = delete;
+
+	virtual IntersectResult intersect(const Ray3D& ray) const;
+
+	virtual double calcDistance(const Ray3D& ray) const { throw Exception("Illegal function call: 'FlatBVH' is an abstract class!"); }
+
+	virtual pair<Vector3D, Vector3D> calcPositionAndNormal(const Ray3D& ray, double distance) const { throw Exception("Illegal function call: 'FlatBVH' is an abstract class!"); }
+
+	virtual AABB getBounds() const;
+
+	// Nodes [0, nodeCount()), the root first; empty without bounded geometry.
+	const Node* nodes() const { return _nodes; }
+
+	int nodeCount() const { return _nodeCount; }
+
+	size_t nodeMemory() const { return _nodeCount * sizeof(Node); }
+
+	// Bounded geometries, in the order the leaves refer to them.
+	const vector<shared_ptr<Geometry>>& primitives() const { return _primitives; }
+
+	const vector<shared_ptr<Geometry>>& unbounded() const { return _unbounded; }
+
+	// SAH cost of a ray through the root: expected nodes visited plus geometries tested.
+	double cost() const;
+
+	// Bounds rounded outwards to floats, so the float boxes contain the double ones.
+	static void toFloat(const AABB& box, float min[3], float max[3]);
+
+	// 30 bit Morton code of a point in [0, 1]^3.
+	static uint32_t morton(float x, float y, float z);
+
+	// Sorts by the high 32 bits, stable, with all threads.
+	static void radixSort(vector<uint64_t>& keys);
+
+private:
+	struct Box {
+		float min[3], max[3];
+
+		void clear() {
+			min[0] = min[1] = min[2] = std::numeric_limits<float>::infinity();
+			max[0] = max[1] = max[2] = -std::numeric_limits<float>::infinity();
+		}
+
+		void expand(const Box& b) {
+			for (int k = 0; k < 3; ++k) {
+				min[k] = std::min(min[k], b.min[k]);
+				max[k] = std::max(max[k], b.max[k]);
+			}
+		}
+
+		void expand(const float p[3]) {
+			for (int k = 0; k < 3; ++k) {
+				min[k] = std::min(min[k], p[k]);
+				max[k] = std::max(max[k], p[k]);
+			}
+		}
+
+		float area() const {
+			const float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+			return dx < 0 ? 0 : 2 * (dx * dy + dy * dz + dz * dx);
+		}
+	};
+
+	// Range [begin, end) of _refs below 'node'.
+	struct Task {
+		int node, begin, end, depth;
+	};
+
+	// Splits a task in two, or makes it a leaf and returns false. 'parallel' bins with all threads.
+	bool split(const Task& task, bool parallel, Task& left, Task& right);
+
+	int splitSAH(const Task& task, bool parallel);
+
+	int splitLBVH(const Task& task) const;
+
+	void buildRecursive(const Task& task);
+
+	void updateBounds(int node);
+
+	static float hit(const Node& node, const float o[3], const float inverse[3], float tmax);
+
+private:
+	Node* _nodes;
+	int _nodeCount;
+	size_t _capacity;
+
+	vector<shared_ptr<Geometry>> _primitives;
+	vector<shared_ptr<Geometry>> _unbounded;
+
+	Method _method;
+	int _maxLeafSize;
+
+	// Build only: bounds and centers of the geometries, their order, and their Morton codes in
+	// that order.
+	vector<Box> _boxes;
+	vector<float> _centers;
+	vector<int> _refs;
+	vector<uint32_t> _codes;
+	std::atomic<int> _used;
+
+	// Deeper ranges are split in the middle, which takes at most 31 more levels to reach leaves,
+	// for fewer than 2^31 geometries. The traversal stack holds at most one entry more than the
+	// depth of the tree.
+	static const int maxDepth = 96;
+	static const int stackSize = maxDepth + 32 + 2;
+};
+
+
+FlatBVH::FlatBVH(const vector<shared_ptr<Geometry>>& geometries, Method method, int maxLeafSize)
+	: _nodes(nullptr)
+	, _nodeCount(0)
+	, _capacity(0)
+	, _method(method)
+	, _maxLeafSize(std::max(1, maxLeafSize))
+	, _used(0) {
+	vector<shared_ptr<Geometry>> bounded;
+
+	for (auto& geometry : geometries) {
+		const AABB bounds = geometry->getBounds();
+
+		if (!bounds.isFinite()) {
+			_unbounded.push_back(geometry);
+			continue;
+		}
+
+		Box box;
+		toFloat(bounds, box.min, box.max);
+
+		bounded.push_back(geometry);
+		_boxes.push_back(box);
+	}
+
+	const int n = (int)bounded.size();
+
+	if (n == 0) return;
+
+	// Centers, and their bounds for the Morton codes.
+	_centers.resize(3 * (size_t)n);
+	Box centroids;
+	centroids.clear();
+
+#pragma omp parallel
+	{
+		Box local;
+		local.clear();
+
+#pragma omp for schedule(static)
+		for (int i = 0; i < n; ++i) {
+			float* c = &_centers[3 * (size_t)i];
+
+			for (int k = 0; k < 3; ++k) c[k] = 0.5f * (_boxes[i].min[k] + _boxes[i].max[k]);
+
+			local.expand(c);
+		}
+
+#pragma omp critical
+		centroids.expand(local);
+	}
+
+	vector<uint64_t> keys(n);
+
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < n; ++i) {
+		float p[3];
+
+		for (int k = 0; k < 3; ++k) {
+			const float extent = centroids.max[k] - centroids.min[k];
+			p[k] = extent > 0 ? (_centers[3 * (size_t)i + k] - centroids.min[k]) / extent : 0.5f;
+		}
+
+		keys[i] = (uint64_t)morton(p[0], p[1], p[2]) << 32 | (uint32_t)i;
+	}
+
+	radixSort(keys);
+
+	_refs.resize(n);
+	_codes.resize(n);
+
+	for (int i = 0; i < n; ++i) {
+		_refs[i] = (int)(uint32_t)keys[i];
+		_codes[i] = (uint32_t)(keys[i] >> 32);
+	}
+
+	vector<uint64_t>().swap(keys);
+
+	// n leaves at most, so n - 1 pairs of children, after the root and the padding node.
+	_capacity = 2 * (size_t)n;
+	_nodes = static_cast<Node*>(AlignedAllocator::allocate(_capacity * sizeof(Node)));
+	_nodes[1] = Node{ { 0, 0, 0 }, 0, { 0, 0, 0 }, 0 };
+	_used = 2;
+
+	// Top of the tree: ranges split one at a time with all threads.
+#ifdef _OPENMP
+	const int threads = omp_get_max_threads();
+#else
+	const int threads = 1;
+#endif
+	const int grain = std::max(4096, n / (8 * threads));
+
+	vector<Task> large{ Task{ 0, 0, n, 0 } }, small, top;
+
+	while (!large.empty()) {
+		const Task task = large.back();
+		large.pop_back();
+
+		if (task.end - task.begin <= grain) {
+			small.push_back(task);
+			continue;
+		}
+
+		Task left, right;
+
+		if (split(task, threads > 1, left, right)) {
+			top.push_back(task);
+			large.push_back(left);
+			large.push_back(right);
+		}
+	}
+
+	// The rest: one range per thread.
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int i = 0; i < (int)small.size(); ++i)
+		buildRecursive(small[i]);
+
+	for (auto task = top.rbegin(); task != top.rend(); ++task)
+		updateBounds(task->node);
+
+	_nodeCount = _used;
+
+	_primitives.resize(n);
+
+	for (int i = 0; i < n; ++i)
+		_primitives[i] = bounded[_refs[i]];
+
+	vector<Box>().swap(_boxes);
+	vector<float>().swap(_centers);
+	vector<int>().swap(_refs);
+	vector<uint32_t>().swap(_codes);
+}
+
+
+bool FlatBVH::split(const Task& task, bool parallel, Task& left, Task& right) {
+	Node& node = _nodes[task.node];
+
+	if (task.end - task.begin <= _maxLeafSize) {
+		Box box;
+		box.clear();
+
+		for (int i = task.begin; i < task.end; ++i)
+			box.expand(_boxes[_refs[i]]);
+
+		node = Node{ { box.min[0], box.min[1], box.min[2] }, task.begin, { box.max[0], box.max[1], box.max[2] }, task.end - task.begin };
+
+		return false;
+	}
+
+	int mid = (task.begin + task.end) / 2;
+
+	if (task.depth < maxDepth) mid = _method == SAH ? splitSAH(task, parallel) : splitLBVH(task);
+
+	const int children = _used.fetch_add(2);
+
+	node.offset = children;
+	node.count = 0;
+
+	left = Task{ children, task.begin, mid, task.depth + 1 };
+	right = Task{ children + 1, mid, task.end, task.depth + 1 };
+
+	return true;
+}
+
+/*------------------------------------------------------------------------------------------/
+| function:    splitSAH
+| description:
+|              Partition a range at the least SAH cost over 32 bins of the widest center axis.
+|
+| input:       @param task: the range.
+|              @param parallel: bin with all threads.
+|
+| return:      the first index of the right half
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+int FlatBVH::splitSAH(const Task& task, bool parallel) {
+	const int binCount = 32;
+	const int begin = task.begin, end = task.end;
+
+	Box centroids;
+	centroids.clear();
+
+#pragma omp parallel if(parallel)
+	{
+		Box local;
+		local.clear();
+
+#pragma omp for schedule(static)
+		for (int i = begin; i < end; ++i)
+			local.expand(&_centers[3 * (size_t)_refs[i]]);
+
+#pragma omp critical
+		centroids.expand(local);
+	}
+
+	int axis = 0;
+
+	for (int k = 1; k < 3; ++k)
+		if (centroids.max[k] - centroids.min[k] > centroids.max[axis] - centroids.min[axis]) axis = k;
+
+	const float lo = centroids.min[axis], extent = centroids.max[axis] - lo;
+	const int middle = (begin + end) / 2;
+
+	if (!(extent > 0)) return middle;
+
+	const float scale = binCount / extent;
+
+	auto binOf = [&](int ref) { return std::min(binCount - 1, (int)((_centers[3 * (size_t)ref + axis] - lo) * scale)); };
+
+	Box bins[binCount];
+	int counts[binCount] = { 0 };
+
+	for (Box& bin : bins) bin.clear();
+
+#pragma omp parallel if(parallel)
+	{
+		Box localBins[binCount];
+		int localCounts[binCount] = { 0 };
+
+		for (Box& bin : localBins) bin.clear();
+
+#pragma omp for schedule(static)
+		for (int i = begin; i < end; ++i) {
+			const int bin = binOf(_refs[i]);
+
+			localBins[bin].expand(_boxes[_refs[i]]);
+			++localCounts[bin];
+		}
+
+#pragma omp critical
+		for (int k = 0; k < binCount; ++k) {
+			bins[k].expand(localBins[k]);
+			counts[k] += localCounts[k];
+		}
+	}
+
+	// Cost of the split after bin k, from the left and the right.
+	float leftCost[binCount];
+	Box box;
+	box.clear();
+	int count = 0;
+
+	for (int k = 0; k < binCount - 1; ++k) {
+		box.expand(bins[k]);
+		count += counts[k];
+		leftCost[k] = box.area() * count;
+	}
+
+	box.clear();
+	count = 0;
+
+	float bestCost = std::numeric_limits<float>::infinity();
+	int bestBin = -1;
+
+	for (int k = binCount - 1; k > 0; --k) {
+		box.expand(bins[k]);
+		count += counts[k];
+
+		const float cost = leftCost[k - 1] + box.area() * count;
+
+		if (cost < bestCost) {
+			bestCost = cost;
+			bestBin = k;
+		}
+	}
+
+	if (bestBin < 0) return middle;
+
+	const int mid = (int)(std::partition(_refs.begin() + begin, _refs.begin() + end, [&](int ref) { return binOf(ref) < bestBin; }) - _refs.begin());
+
+	return mid == begin || mid == end ? middle : mid;
+}
+
+int FlatBVH::splitLBVH(const Task& task) const {
+	const uint32_t first = _codes[task.begin], last = _codes[task.end - 1];
+
+	if (first == last) return (task.begin + task.end) / 2;
+
+	// The highest bit in which the range differs is 0 in its left part and 1 in its right one.
+	int bit = 31;
+	while (!((first ^ last) >> bit & 1)) --bit;
+
+	return (int)(std::partition_point(_codes.begin() + task.begin, _codes.begin() + task.end, [&](uint32_t code) { return !(code >> bit & 1); }) - _codes.begin());
+}
+
+void FlatBVH::buildRecursive(const Task& task) {
+	Task left, right;
+
+	if (!split(task, false, left, right)) return;
+
+	buildRecursive(left);
+	buildRecursive(right);
+	updateBounds(task.node);
+}
+
+void FlatBVH::updateBounds(int node) {
+	Node& n = _nodes[node];
+	const Node& l = _nodes[n.offset];
+	const Node& r = _nodes[n.offset + 1];
+
+	for (int k = 0; k < 3; ++k) {
+		n.min[k] = std::min(l.min[k], r.min[k]);
+		n.max[k] = std::max(l.max[k], r.max[k]);
+	}
+}
+
+
+float FlatBVH::hit(const Node& node, const float o[3], const float inverse[3], float tmax) {
+	float tmin = 0;
+
+	for (int k = 0; k < 3; ++k) {
+		float t0 = (node.min[k] - o[k]) * inverse[k];
+		float t1 = (node.max[k] - o[k]) * inverse[k];
+
+		if (t0 > t1) std::swap(t0, t1);
+
+		tmin = std::max(tmin, t0);
+		tmax = std::min(tmax, t1 * 1.0000004f);    // float rounding must not lose a grazing hit
+	}
+
+	return tmin <= tmax ? tmin : std::numeric_limits<float>::infinity();
+}
+
+IntersectResult FlatBVH::intersect(const Ray3D& ray) const {
+	double minDist = std::numeric_limits<double>::max();
+	const Geometry* nearest = nullptr;
+
+	Profiler::countIntersectionTests((int)_unbounded.size());
+
+	for (auto& geometry : _unbounded) {
+		const double dist = geometry->calcDistance(ray);
+
+		if (dist < minDist) {
+			minDist = dist;
+			nearest = geometry.get();
+		}
+	}
+
+	if (_nodeCount > 0) {
+		float o[3], inverse[3];
+
+		for (int k = 0; k < 3; ++k) {
+			const double d = ray.getDirection()[k];
+
+			o[k] = (float)ray.getOrigin()[k];
+			// A large finite value in place of infinity: 0 * it is 0, not NaN.
+			inverse[k] = d != 0 ? (float)(1 / d) : std::copysign(1e30f, (float)d);
+		}
+
+		struct Entry {
+			int node;
+			float t;
+		} stack[stackSize];
+
+		int size = 0;
+		float t = hit(_nodes[0], o, inverse, (float)minDist);
+
+		if (t < minDist) stack[size++] = Entry{ 0, t };
+
+		while (size > 0) {
+			const Entry entry = stack[--size];
+
+			if (entry.t >= minDist) continue;
+
+			const Node& node = _nodes[entry.node];
+
+			if (node.isLeaf()) {
+				Profiler::countIntersectionTests(node.count);
+
+				for (int i = node.offset; i < node.offset + node.count; ++i) {
+					const double dist = _primitives[i]->calcDistance(ray);
+
+					if (dist < minDist) {
+						minDist = dist;
+						nearest = _primitives[i].get();
+					}
+				}
+
+				continue;
+			}
+
+			const float tl = hit(_nodes[node.offset], o, inverse, (float)minDist);
+			const float tr = hit(_nodes[node.offset + 1], o, inverse, (float)minDist);
+
+			// The nearer child on top.
+			if (tl <= tr) {
+				if (tr < minDist) stack[size++] = Entry{ node.offset + 1, tr };
+				if (tl < minDist) stack[size++] = Entry{ node.offset, tl };
+			}
+			else {
+				if (tl < minDist) stack[size++] = Entry{ node.offset, tl };
+				if (tr < minDist) stack[size++] = Entry{ node.offset + 1, tr };
+			}
+		}
+	}
+
+	if (!nearest) return IntersectResult::noHit;
+
+	auto&& r = nearest->calcPositionAndNormal(ray, minDist);
+	return IntersectResult(nearest, minDist, r.first, r.second);
+}
+
+AABB FlatBVH::getBounds() const {
+	if (!_unbounded.empty()) return AABB::infinite();
+
+	if (_nodeCount == 0) return AABB();
+
+	const Node& root = _nodes[0];
+	return AABB(Vector3D(root.min[0], root.min[1], root.min[2]), Vector3D(root.max[0], root.max[1], root.max[2]));
+}
+
+double FlatBVH::cost() const {
+	if (_nodeCount == 0) return (double)_unbounded.size();
+
+	auto area = [](const Node& node) {
+		const double dx = node.max[0] - node.min[0], dy = node.max[1] - node.min[1], dz = node.max[2] - node.min[2];
+		return 2 * (dx * dy + dy * dz + dz * dx);
+	};
+
+	double sum = 0;
+
+	for (int i = 0; i < _nodeCount; ++i)
+		if (i != 1) sum += area(_nodes[i]) * (_nodes[i].isLeaf() ? 1 + _nodes[i].count : 1);
+
+	const double root = area(_nodes[0]);
+
+	return _unbounded.size() + (root > 0 ? sum / root : (double)_primitives.size());
+}
+
+
+void FlatBVH::toFloat(const AABB& box, float min[3], float max[3]) {
+	for (int k = 0; k < 3; ++k) {
+		min[k] = (float)box.getMin()[k];
+		max[k] = (float)box.getMax()[k];
+
+		if (min[k] > box.getMin()[k]) min[k] = std::nextafter(min[k], -std::numeric_limits<float>::infinity());
+		if (max[k] < box.getMax()[k]) max[k] = std::nextafter(max[k], std::numeric_limits<float>::infinity());
+	}
+}
+
+uint32_t FlatBVH::morton(float x, float y, float z) {
+	// 10 bits per axis, spread to every third bit.
+	auto spread = [](float v) {
+		uint32_t b = (uint32_t)std::min(std::max(v * 1024.f, 0.f), 1023.f);
+
+		b = (b | (b << 16)) & 0x030000FF;
+		b = (b | (b << 8)) & 0x0300F00F;
+		b = (b | (b << 4)) & 0x030C30C3;
+		b = (b | (b << 2)) & 0x09249249;
+
+		return b;
+	};
+
+	return spread(x) << 2 | spread(y) << 1 | spread(z);
+}
+
+void FlatBVH::radixSort(vector<uint64_t>& keys) {
+	const int n = (int)keys.size();
+#ifdef _OPENMP
+	const int threads = omp_get_max_threads();
+#else
+	const int threads = 1;
+#endif
+
+	vector<uint64_t> buffer(n);
+	vector<size_t> offsets(256 * (size_t)threads);
+
+	for (int shift = 32; shift < 64; shift += 8) {
+		std::fill(offsets.begin(), offsets.end(), 0);
+
+#pragma omp parallel num_threads(threads)
+		{
+#ifdef _OPENMP
+			const int t = omp_get_thread_num(), count = omp_get_num_threads();
+#else
+			const int t = 0, count = 1;
+#endif
+			const int begin = (int)((int64_t)n * t / count), end = (int)((int64_t)n * (t + 1) / count);
+			size_t* offset = &offsets[256 * (size_t)t];
+
+			for (int i = begin; i < end; ++i)
+				++offset[keys[i] >> shift & 255];
+
+#pragma omp barrier
+#pragma omp single
+			{
+				// Digit by digit, thread by thread: every thread's keys of a digit follow those
+				// of the threads before it, which keeps the sort stable.
+				size_t sum = 0;
+
+				for (int digit = 0; digit < 256; ++digit) {
+					for (int i = 0; i < count; ++i) {
+						const size_t c = offsets[256 * (size_t)i + digit];
+						offsets[256 * (size_t)i + digit] = sum;
+						sum += c;
+					}
+				}
+			}
+
+			for (int i = begin; i < end; ++i)
+				buffer[offset[keys[i] >> shift & 255]++] = keys[i];
+		}
+
+		keys.swap(buffer);
+	}
+}
@@ -19,13 +19,16 @@
 #include "Ray3D.h"
 #include "Material.h"
 #include "IntersectResult.h"
+#include "AABB.h"
+
+#include <atomic>
 
 class Geometry {
 public:
 
-	Geometry() {}
+	Geometry() : _id(nextId()) {}
 
-	Geometry(const std::shared_ptr<Material>& material) : _material(material) {}
+	Geometry(const std::shared_ptr<Material>& material) : _material(material), _id(nextId()) {}
 
 	virtual IntersectResult intersect(const Ray3D& ray) const = 0;
 
@@ -35,10 +38,23 @@ public:
 
 	virtual ~Geometry(){}
 
+	// Bounds of everything the geometry can hit; infinite unless overridden.
+	virtual AABB getBounds() const { return AABB::infinite(); }
+
 	const std::shared_ptr<Material>& getMaterial() const { return _material; }
 
 	void setMaterial(const std::shared_ptr<Material>& material) { _material = material; }
 
+	// Distinct for every geometry constructed, in construction order.
+	int getId() const { return _id; }
+
+private:
+	static int nextId() {
+		static std::atomic<int> counter(0);
+		return counter++;
+	}
+
 private:
 	std::shared_ptr<Material> _material;
+	int _id;
 };
\ No newline at end of file
@@ -0,0 +1,265 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     IncrementalRayTracer.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Whitted ray tracing of a sequence of frames that traces again only the pixels the
+//                changes between frames can reach.
+//
+//                Every pixel keeps the segments of its ray tree: the primary ray, the reflected rays
+//                and the shadow rays, each up to what it hit. They are recorded by a proxy the scene
+//                is traced through. For a new frame, the geometries that were removed or replaced
+//                since the last one, and those that replaced them, give boxes around everything that
+//                changed. A segment that misses all of them has the same hit as before, so a pixel
+//                whose segments all miss has the same ray tree and keeps its color.
+//
+//                Frames come as lists of geometry, as AnimationFrame has them: unchanged geometry is
+//                the same object from frame to frame. Changing the lights or the camera traces the
+//                whole image, as does changing an unbounded geometry such as a plane.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Render.h"
+#include "AABB.h"
+
+#include <limits>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+class IncrementalRayTracer {
+public:
+	IncrementalRayTracer(const Size& size, int maxReflect);
+
+	// The image of the frame, the same as Render::rayTrace of the union of 'geometries'.
+	const Matrix<uint8>& render(const vector<shared_ptr<Geometry>>& geometries, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera);
+
+	// Pixels traced by the last render().
+	int traced() const { return _traced; }
+
+	// Make the next render() trace every pixel.
+	void invalidate() { _valid = false; }
+
+private:
+	struct Segment {
+		float origin[3];
+		float inverse[3];       // 1 / direction, for the slab test
+		float length;           // infinite for a ray that hit nothing
+	};
+
+	struct Box {
+		float min[3], max[3];
+	};
+
+	// Records every ray cast into the scene, with the distance to its hit.
+	class RecordingGeometry : public Geometry {
+	public:
+		RecordingGeometry(const Geometry& scene, vector<Segment>& segments) : _scene(scene), _segments(segments) {}
+
+		virtual IntersectResult intersect(const Ray3D& ray) const {
+			const IntersectResult result = _scene.intersect(ray);
+			record(ray, result.getGeometry() ? result.getDistance() : std::numeric_limits<double>::max());
+			return result;
+		}
+
+		virtual double calcDistance(const Ray3D& ray) const {
+			const double distance = _scene.calcDistance(ray);
+			record(ray, distance);
+			return distance;
+		}
+
+		virtual pair<Vector3D, Vector3D> calcPositionAndNormal(const Ray3D& ray, double distance) const { return _scene.calcPositionAndNormal(ray, distance); }
+
+		virtual AABB getBounds() const { return _scene.getBounds(); }
+
+	private:
+		void record(const Ray3D& ray, double distance) const;
+
+		const Geometry& _scene;
+		vector<Segment>& _segments;
+	};
+
+	static bool reaches(const Segment* begin, const Segment* end, const vector<Box>& changed);
+
+	void renderRow(const Geometry& scene, const vector<Box>& changed, int i, int& traced);
+
+private:
+	Matrix<uint8> _image;
+	int _maxReflect;
+
+	// Segments of row i, pixel after pixel; those of pixel j are [_offsets[i][j], _offsets[i][j + 1]).
+	vector<vector<Segment>> _segments;
+	vector<vector<int>> _offsets;
+
+	vector<shared_ptr<Geometry>> _geometries;
+	vector<shared_ptr<Light>> _lights;
+	shared_ptr<PerspectiveCamera> _camera;
+
+	bool _valid;
+	int _traced;
+};
+
+
+IncrementalRayTracer::IncrementalRayTracer(const Size& size, int maxReflect)
+	: _maxReflect(maxReflect)
+	, _segments(size.height())
+	, _offsets(size.height(), vector<int>(size.width() + 1, 0))
+	, _valid(false)
+	, _traced(0) {
+	_image.create(size.height(), size.width(), size.channel(), true);
+}
+
+void IncrementalRayTracer::RecordingGeometry::record(const Ray3D& ray, double distance) const {
+	const Vector3D& o = ray.getOrigin();
+	const Vector3D& d = ray.getDirection();
+	const float length = distance < std::numeric_limits<double>::max() ? (float)distance : std::numeric_limits<float>::infinity();
+
+	_segments.push_back(Segment{ { (float)o.x(), (float)o.y(), (float)o.z() }, { float(1 / d.x()), float(1 / d.y()), float(1 / d.z()) }, length });
+}
+
+
+/*------------------------------------------------------------------------------------------/
+| function:    render
+| description:
+|              Render a frame, tracing only the pixels that can differ from the last frame.
+|
+| input:       @param geometries: the scene; geometry unchanged since the last frame must be the same
+|              object.
+|              @param lights, camera: as for Render::rayTrace.
+|
+| return:      the image, valid until the next call
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+const Matrix<uint8>& IncrementalRayTracer::render(const vector<shared_ptr<Geometry>>& geometries, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera) {
+	vector<AABB> changed;
+
+	if (!_valid || lights != _lights || *_camera != camera) {
+		changed.push_back(AABB::infinite());
+	}
+	else {
+		std::unordered_set<const Geometry*> before, after;
+
+		for (auto& g : _geometries) before.insert(g.get());
+		for (auto& g : geometries) after.insert(g.get());
+
+		auto add = [&](const Geometry& geometry) {
+			const AABB bounds = geometry.getBounds();
+
+			if (!bounds.isFinite()) {
+				changed.assign(1, AABB::infinite());
+				return;
+			}
+
+			// The segments are kept in floats; the margin covers their rounding.
+			const Vector3D& lo = bounds.getMin();
+			const Vector3D& hi = bounds.getMax();
+			const double scale = std::max({ std::abs(lo.x()), std::abs(lo.y()), std::abs(lo.z()), std::abs(hi.x()), std::abs(hi.y()), std::abs(hi.z()) });
+
+			changed.push_back(bounds.padded(1e-4 * (1 + scale)));
+		};
+
+		for (auto& g : _geometries)
+			if (!after.count(g.get())) add(*g);
+
+		for (auto& g : geometries)
+			if (!before.count(g.get())) add(*g);
+	}
+
+	_geometries = geometries;
+	_lights = lights;
+	_camera = std::make_shared<PerspectiveCamera>(camera);
+	_valid = true;
+	_traced = 0;
+
+	if (changed.empty()) return _image;
+
+	vector<Box> boxes;
+
+	for (const AABB& box : changed) {
+		const Vector3D& lo = box.getMin();
+		const Vector3D& hi = box.getMax();
+
+		boxes.push_back(Box{ { (float)lo.x(), (float)lo.y(), (float)lo.z() }, { (float)hi.x(), (float)hi.y(), (float)hi.z() } });
+	}
+
+	const UnionGeometry scene(geometries);
+	const int height = _image.height();
+	int traced = 0;
+
+#pragma omp parallel for schedule(dynamic, 1) reduction(+: traced)
+	for (int i = 0; i < height; ++i)
+		renderRow(scene, boxes, i, traced);
+
+	_traced = traced;
+
+	return _image;
+}
+
+void IncrementalRayTracer::renderRow(const Geometry& scene, const vector<Box>& changed, int i, int& traced) {
+	const int width = _image.width();
+	const vector<Segment>& old = _segments[i];
+	vector<int>& offsets = _offsets[i];
+
+	// Most rows of a small change keep all their pixels.
+	bool dirty = false;
+
+	for (int j = 0; j < width && !dirty; ++j)
+		dirty = reaches(old.data() + offsets[j], old.data() + offsets[j + 1], changed);
+
+	if (!dirty) return;
+
+	vector<Segment> segments;
+	segments.reserve(old.size());
+
+	const RecordingGeometry recorder(scene, segments);
+	int begin = 0;
+
+	for (int j = 0; j < width; ++j) {
+		const Segment* first = old.data() + offsets[j];
+		const Segment* last = old.data() + offsets[j + 1];
+
+		if (reaches(first, last, changed)) {
+			Render::rayTracePixel(recorder, _lights, *_camera, _maxReflect, _image, i, j);
+			++traced;
+		}
+		else {
+			segments.insert(segments.end(), first, last);
+		}
+
+		offsets[j] = begin;
+		begin = (int)segments.size();
+	}
+
+	offsets[width] = begin;
+	_segments[i].swap(segments);
+}
+
+bool IncrementalRayTracer::reaches(const Segment* begin, const Segment* end, const vector<Box>& changed) {
+	for (const Segment* s = begin; s != end; ++s) {
+		for (const Box& box : changed) {
+			float tmin = 0, tmax = s->length;
+
+			for (int axis = 0; axis < 3 && tmin <= tmax; ++axis) {
+				float t0 = (box.min[axis] - s->origin[axis]) * s->inverse[axis];
+				float t1 = (box.max[axis] - s->origin[axis]) * s->inverse[axis];
+
+				// NaN, from an axis parallel ray on a slab boundary, clips nothing.
+				if (t0 > t1) std::swap(t0, t1);
+				if (t0 > tmin) tmin = t0;
+				if (t1 < tmax) tmax = t1;
+			}
+
+			if (tmin <= tmax) return true;
+		}
+	}
+
+	// A pixel with no segments has never been traced.
+	return begin == end;
+}
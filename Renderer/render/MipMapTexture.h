@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     MipMapTexture.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Image texture with a precomputed mip pyramid and trilinear filtering.
+//
+//                Every level is the previous one blurred by IP::gaussianBlurLinearTime and halved.
+//                Levels are stored as 8x8 tiles, each one contiguous, so the texels of a bilinear
+//                lookup share one or two cache lines instead of spanning two image rows.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Texture.h"
+#include "Matrix.h"
+#include "IP.h"
+#include "MyMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+class MipMapTexture : public Texture {
+public:
+
+	// 'image' is an 8 bit gray or RGB image, e.g. from PXMImage::open.
+	explicit MipMapTexture(const Matrix<uint8>& image);
+
+	virtual Color lookup(double u, double v, double width) const;
+
+	int levels() const { return (int)_levels.size(); }
+
+private:
+	static const int tileBits = 3;
+	static const int tileSize = 1 << tileBits;
+
+	struct Level {
+		int height, width, tilesX;
+		Matrix<uint8> tiles;  // one row of tileSize*tileSize RGB texels per tile
+	};
+
+	static Level makeLevel(const Matrix<uint8>& image);
+
+	Color bilinear(const Level& level, double u, double v) const;
+
+	const uint8* texel(const Level& level, int x, int y) const {
+		// wrap around
+		x %= level.width;
+		y %= level.height;
+		if (x < 0) x += level.width;
+		if (y < 0) y += level.height;
+
+		const int tile = (y >> tileBits)*level.tilesX + (x >> tileBits);
+
+		return &level.tiles(tile, ((y & (tileSize - 1)) << tileBits) + (x & (tileSize - 1)));
+	}
+
+private:
+	std::vector<Level> _levels;
+};
+
+
+MipMapTexture::MipMapTexture(const Matrix<uint8>& image) {
+	assert(!image.empty());
+	assert(image.channel() == 1 || image.channel() == 3);
+
+	// The texture repeats, so each level is blurred with a margin copied from the opposite borders.
+	const int margin = 8;
+
+	Matrix<uint8> level = image, padded, blurred;
+
+	for (;;) {
+		_levels.push_back(makeLevel(level));
+
+		if (level.height() == 1 && level.width() == 1) break;
+
+		const int h = level.height(), w = level.width(), c = level.channel();
+
+		padded.create(h + 2 * margin, w + 2 * margin, c, false);
+
+		for (int i = 0; i < padded.height(); ++i)
+			for (int j = 0; j < padded.width(); ++j)
+				for (int k = 0; k < c; ++k)
+					padded(i, j, k) = level(((i - margin) % h + h) % h, ((j - margin) % w + w) % w, k);
+
+		// Each level is prefiltered against aliasing, then decimated by averaging 2x2 texels, which
+		// keeps the texel centres of all levels aligned.
+		IP::gaussianBlurLinearTime(padded, blurred, 2, 1.0);
+
+		Matrix<uint8> next;
+		next.create((h + 1) / 2, (w + 1) / 2, c, false);
+
+		for (int i = 0; i < next.height(); ++i) {
+			for (int j = 0; j < next.width(); ++j) {
+				const int y = margin + 2 * i, x = margin + 2 * j;
+
+				for (int k = 0; k < c; ++k)
+					next(i, j, k) = (uint8)((blurred(y, x, k) + blurred(y, x + 1, k) + blurred(y + 1, x, k) + blurred(y + 1, x + 1, k) + 2) >> 2);
+			}
+		}
+
+		level = std::move(next);
+	}
+}
+
+MipMapTexture::Level MipMapTexture::makeLevel(const Matrix<uint8>& image) {
+	Level level;
+	level.height = image.height();
+	level.width = image.width();
+	level.tilesX = (image.width() + tileSize - 1) / tileSize;
+
+	const int tilesY = (image.height() + tileSize - 1) / tileSize;
+
+	level.tiles.create(tilesY*level.tilesX, tileSize*tileSize, 3);
+
+	for (int i = 0; i < image.height(); ++i) {
+		for (int j = 0; j < image.width(); ++j) {
+			uint8* dst = &level.tiles((i >> tileBits)*level.tilesX + (j >> tileBits), ((i & (tileSize - 1)) << tileBits) + (j & (tileSize - 1)));
+
+			for (int k = 0; k < 3; ++k)
+				dst[k] = image(i, j, image.channel() == 3 ? k : 0);
+		}
+	}
+
+	return level;
+}
+
+
+Color MipMapTexture::lookup(double u, double v, double width) const {
+	// The level whose texels are as wide as the footprint.
+	const double lod = Math::clip(std::log2(std::max(width*std::max(_levels[0].width, _levels[0].height), 1e-9)), 0.0, levels() - 1.0);
+	const int lo = (int)lod;
+	const double t = lod - lo;
+
+	const Color c = bilinear(_levels[lo], u, v);
+
+	if (t == 0) return c;
+
+	return c*(1 - t) + bilinear(_levels[lo + 1], u, v)*t;
+}
+
+Color MipMapTexture::bilinear(const Level& level, double u, double v) const {
+	const double x = u*level.width - 0.5;
+	const double y = v*level.height - 0.5;
+	const double fx = std::floor(x), fy = std::floor(y);
+	const double ax = x - fx, ay = y - fy;
+	const int x0 = (int)fx, y0 = (int)fy;
+
+	const uint8* p00 = texel(level, x0, y0);
+	const uint8* p01 = texel(level, x0 + 1, y0);
+	const uint8* p10 = texel(level, x0, y0 + 1);
+	const uint8* p11 = texel(level, x0 + 1, y0 + 1);
+
+	double rgb[3];
+
+	for (int k = 0; k < 3; ++k) {
+		const double top = p00[k] + (p01[k] - p00[k])*ax;
+		const double bottom = p10[k] + (p11[k] - p10[k])*ax;
+
+		rgb[k] = (top + (bottom - top)*ay) / 255;
+	}
+
+	return Color(rgb[0], rgb[1], rgb[2]);
+}
@@ -46,6 +46,19 @@ public:
 		return Ray3D(_eye, (_front+r+u).norm());
 	}
 
+	// The same ray, as a cone covering one pixel of an image 'height' pixels high.
+	Ray3D generateRay(double x, double y, int height) const {
+		const Ray3D ray = generateRay(x, y);
+
+		return Ray3D(ray.getOrigin(), ray.getDirection(), 0, _fovScaleV / height);
+	}
+
+	bool operator == (const PerspectiveCamera& rhs) const {
+		return _eye == rhs._eye && _front == rhs._front && _up == rhs._up && _fovScaleH == rhs._fovScaleH && _fovScaleV == rhs._fovScaleV;
+	}
+
+	bool operator != (const PerspectiveCamera& rhs) const { return !(*this == rhs); }
+
 private:
 	Vector3D _eye, _front, _refUp, _up, _right;
 	double _fov, _fovScaleH, _fovScaleV;
@@ -0,0 +1,361 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     Profiler.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Counters and timings of a render.
+//
+//                While enabled, the renderers count rays, intersection tests, shadow rays, path
+//                depths and Russian roulette kills, time every tile (or row) and every pixel. Each
+//                thread counts into its own Counters, without locks or atomics, and total() adds
+//                them up. Disabled, every hook costs one relaxed atomic load.
+//
+//                Results are a JSON summary, a trace of the tiles for chrome://tracing, and a false
+//                colour heatmap of the time spent in every pixel.
+//
+//                    Profiler::begin(height, width);
+//                    Render::pathTrace(...);
+//                    Profiler::end();
+//                    Profiler::saveSummary("render.json");
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Matrix.h"
+#include "MyMath.h"
+#include "MyString.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Profiler {
+public:
+
+	// Path depths of 0 .. depthBins - 2 have a bin each, deeper paths share the last one.
+	static const int depthBins = 16;
+
+	struct Counters {
+		uint64_t rays;              // camera and bounce rays traced
+		uint64_t intersectionTests; // ray / primitive tests
+		uint64_t shadowRays;
+		uint64_t rouletteKills;     // paths ended by Russian roulette
+		uint64_t depth[depthBins];  // paths by the depth they ended at
+		uint64_t busyNanoseconds;   // inside tiles
+
+		Counters() { clear(); }
+
+		void clear() {
+			rays = intersectionTests = shadowRays = rouletteKills = busyNanoseconds = 0;
+			std::fill(depth, depth + depthBins, 0);
+		}
+
+		Counters& operator += (const Counters& rhs) {
+			rays += rhs.rays;
+			intersectionTests += rhs.intersectionTests;
+			shadowRays += rhs.shadowRays;
+			rouletteKills += rhs.rouletteKills;
+			busyNanoseconds += rhs.busyNanoseconds;
+
+			for (int i = 0; i < depthBins; ++i)
+				depth[i] += rhs.depth[i];
+
+			return *this;
+		}
+	};
+
+	// Clears everything and starts profiling a frame of height x width pixels.
+	static void begin(int height, int width);
+
+	// Stops profiling.
+	static void end();
+
+	static bool enabled() { return state().enabled.load(std::memory_order_relaxed); }
+
+	// Monotonic clock in nanoseconds.
+	static uint64_t now() {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Hooks for the renderers.
+
+	static void countRay() { if (enabled()) ++local().counters.rays; }
+
+	static void countIntersectionTests(int n) { if (enabled()) local().counters.intersectionTests += n; }
+
+	static void countShadowRay() { if (enabled()) ++local().counters.shadowRays; }
+
+	static void countRouletteKill() { if (enabled()) ++local().counters.rouletteKills; }
+
+	static void countPathEnd(int depth) { if (enabled()) ++local().counters.depth[std::min(depth, depthBins - 1)]; }
+
+	// A tile covering rows [top, top + height) and columns [left, left + width), run from 'start' to 'stop'.
+	static void recordTile(int top, int left, int height, int width, uint64_t start, uint64_t stop);
+
+	static void recordPixel(int i, int j, uint64_t nanoseconds) {
+		if (enabled()) {
+			Matrix<float, AlignedAllocator>& cost = state().cost;
+
+			if (i < cost.height() && j < cost.width()) cost(i, j) += (float)nanoseconds;
+		}
+	}
+
+	// Results; call them after end().
+
+	static Counters total();
+
+	static double wallSeconds() { return (state().stop - state().start) * 1e-9; }
+
+	// Nanoseconds spent in every pixel.
+	static const Matrix<float, AlignedAllocator>& pixelCost() { return state().cost; }
+
+	// The cost of every pixel, on a logarithmic scale from black through blue, red and yellow to white.
+	static Matrix<uint8> heatmap();
+
+	static std::string summary();
+
+	static void saveSummary(const std::string& filepath) { std::ofstream(filepath) << summary(); }
+
+	static void saveChromeTrace(const std::string& filepath);
+
+private:
+	struct TileEvent {
+		int thread;
+		int top, left, height, width;
+		uint64_t start, stop;
+	};
+
+	// Counters of one thread, listed in the state while the thread lives.
+	struct Local {
+		Counters counters;
+		std::vector<TileEvent> tiles;
+		int thread;
+
+		Local();
+
+		~Local();
+	};
+
+	struct State {
+		std::atomic<bool> enabled;
+		std::mutex mutex;
+		std::vector<Local*> threads;
+		Counters retired;                 // of threads that have exited
+		std::vector<TileEvent> retiredTiles;
+		int nextThread;
+		uint64_t start, stop;
+		Matrix<float, AlignedAllocator> cost;    // not pooled: the state outlives the thread_local pools
+
+		State() : enabled(false), nextThread(0), start(0), stop(0) {}
+	};
+
+	static State& state() {
+		static State s;
+		return s;
+	}
+
+	static Local& local() {
+		static thread_local Local l;
+		return l;
+	}
+
+	static std::vector<TileEvent> allTiles();
+};
+
+
+Profiler::Local::Local() {
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+
+	thread = s.nextThread++;
+	s.threads.push_back(this);
+}
+
+Profiler::Local::~Local() {
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+
+	s.retired += counters;
+	s.retiredTiles.insert(s.retiredTiles.end(), tiles.begin(), tiles.end());
+	s.threads.erase(std::find(s.threads.begin(), s.threads.end(), this));
+}
+
+
+void Profiler::begin(int height, int width) {
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+
+	for (Local* l : s.threads) {
+		l->counters.clear();
+		l->tiles.clear();
+	}
+
+	s.retired.clear();
+	s.retiredTiles.clear();
+	s.cost.create(height, width, 1);
+	s.start = now();
+	s.stop = s.start;
+	s.enabled = true;
+}
+
+void Profiler::end() {
+	State& s = state();
+
+	s.enabled = false;
+	s.stop = now();
+}
+
+void Profiler::recordTile(int top, int left, int height, int width, uint64_t start, uint64_t stop) {
+	if (!enabled()) return;
+
+	Local& l = local();
+
+	l.counters.busyNanoseconds += stop - start;
+	l.tiles.push_back(TileEvent{ l.thread, top, left, height, width, start, stop });
+}
+
+Profiler::Counters Profiler::total() {
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	Counters c = s.retired;
+
+	for (Local* l : s.threads)
+		c += l->counters;
+
+	return c;
+}
+
+std::vector<Profiler::TileEvent> Profiler::allTiles() {
+	State& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	std::vector<TileEvent> tiles = s.retiredTiles;
+
+	for (Local* l : s.threads)
+		tiles.insert(tiles.end(), l->tiles.begin(), l->tiles.end());
+
+	std::sort(tiles.begin(), tiles.end(), [](const TileEvent& a, const TileEvent& b) { return a.start < b.start; });
+
+	return tiles;
+}
+
+
+Matrix<uint8> Profiler::heatmap() {
+	const Matrix<float, AlignedAllocator>& cost = pixelCost();
+
+	if (cost.empty()) return Matrix<uint8>();
+
+	Matrix<uint8> m(cost.height(), cost.width(), 3);
+
+	std::vector<float> sorted;
+
+	for (int i = 0; i < cost.length(); ++i)
+		if (cost.data()[i] > 0) sorted.push_back(cost.data()[i]);
+
+	if (sorted.empty()) return m;
+
+	// The scale spans the 1st to the 99th percentile, so that a few pixels interrupted by the
+	// scheduler do not flatten the rest.
+	std::sort(sorted.begin(), sorted.end());
+
+	const float low = sorted[sorted.size() / 100];
+	const float high = sorted[sorted.size() - 1 - sorted.size() / 100];
+
+	const double range = std::max(std::log((double)high / low), 1e-6);
+
+	// black, blue, red, yellow, white
+	static const double stops[5][3] = { { 0, 0, 0 }, { 0, 0, 1 }, { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 } };
+
+	for (int i = 0; i < cost.height(); ++i) {
+		for (int j = 0; j < cost.width(); ++j) {
+			const double t = cost(i, j) > 0 ? Math::clip(std::log(cost(i, j) / low) / range, 0.0, 1.0) * 4 : 0;
+			const int k = std::min((int)t, 3);
+			const double f = t - k;
+
+			for (int c = 0; c < 3; ++c)
+				m(i, j, c) = (uint8)((stops[k][c] * (1 - f) + stops[k + 1][c] * f) * 255 + 0.5);
+		}
+	}
+
+	return m;
+}
+
+std::string Profiler::summary() {
+	const Counters c = total();
+	const std::vector<TileEvent> tiles = allTiles();
+	const double wall = wallSeconds();
+
+	uint64_t tileMin = 0, tileMax = 0, tileSum = 0;
+
+	for (size_t i = 0; i < tiles.size(); ++i) {
+		const uint64_t d = tiles[i].stop - tiles[i].start;
+
+		tileMin = i == 0 ? d : std::min(tileMin, d);
+		tileMax = std::max(tileMax, d);
+		tileSum += d;
+	}
+
+	std::string depth;
+
+	for (int i = 0; i < depthBins; ++i)
+		depth += String::format("%s%llu", i ? ", " : "", (unsigned long long)c.depth[i]);
+
+	std::vector<int> ids;
+
+	for (const TileEvent& t : tiles)
+		ids.push_back(t.thread);
+
+	std::sort(ids.begin(), ids.end());
+
+	const int threads = (int)(std::unique(ids.begin(), ids.end()) - ids.begin());
+
+	std::string s;
+	s += "{\n";
+	s += String::format("  \"wallSeconds\": %.6f,\n", wall);
+	s += String::format("  \"rays\": %llu,\n", (unsigned long long)c.rays);
+	s += String::format("  \"raysPerSecond\": %.0f,\n", wall > 0 ? c.rays / wall : 0.0);
+	s += String::format("  \"intersectionTests\": %llu,\n", (unsigned long long)c.intersectionTests);
+	s += String::format("  \"shadowRays\": %llu,\n", (unsigned long long)c.shadowRays);
+	s += String::format("  \"rouletteKills\": %llu,\n", (unsigned long long)c.rouletteKills);
+	s += "  \"pathDepth\": [" + depth + "],\n";
+	s += String::format("  \"tiles\": %d,\n", (int)tiles.size());
+	s += String::format("  \"tileNanoseconds\": { \"min\": %llu, \"mean\": %llu, \"max\": %llu },\n",
+		(unsigned long long)tileMin, (unsigned long long)(tiles.empty() ? 0 : tileSum / tiles.size()), (unsigned long long)tileMax);
+	s += String::format("  \"threads\": %d,\n", threads);
+	// Busy time over wall time of all threads; low values mean idle threads or serial parts.
+	s += String::format("  \"parallelEfficiency\": %.4f\n", threads > 0 && wall > 0 ? c.busyNanoseconds * 1e-9 / (wall * threads) : 0.0);
+	s += "}\n";
+
+	return s;
+}
+
+void Profiler::saveChromeTrace(const std::string& filepath) {
+	const std::vector<TileEvent> tiles = allTiles();
+	const uint64_t origin = state().start;
+	std::ofstream file(filepath);
+
+	file << "{\"traceEvents\": [\n";
+
+	// Complete events, in microseconds from begin().
+	for (size_t i = 0; i < tiles.size(); ++i) {
+		const TileEvent& t = tiles[i];
+
+		file << String::format("{\"name\": \"tile %d,%d\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, "
+			"\"args\": {\"top\": %d, \"left\": %d, \"height\": %d, \"width\": %d}}%s\n",
+			t.top, t.left, t.thread, (t.start - origin) * 1e-3, (t.stop - t.start) * 1e-3,
+			t.top, t.left, t.height, t.width, i + 1 < tiles.size() ? "," : "");
+	}
+
+	file << "]}\n";
+}
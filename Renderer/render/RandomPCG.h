@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     RandomPCG.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Counter-based random numbers: the PCG4D hash of Jarzynski and Olano, "Hash
+//                Functions for GPU Rendering" (JCGT 2020).
+//
+//                The d-th number of a sample is a function of (pixel, sample, d, frame) alone, so a
+//                render does not depend on how pixels are split into tiles, threads or machines, nor
+//                on the order they run in. The hash is a few multiplies, adds and shifts without
+//                branches, and yields 4 numbers per call.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+
+class RandomPCG {
+public:
+
+	RandomPCG(uint32_t pixel, uint32_t sample, uint32_t frame = 0)
+		: _pixel(pixel)
+		, _sample(sample)
+		, _frame(frame)
+		, _dimension(0)
+	{}
+
+	// Next dimension, in [0, 1).
+	double operator()() {
+		if ((_dimension & 3) == 0) hash(_pixel, _sample, _dimension >> 2, _frame, _block);
+
+		return _block[_dimension++ & 3] * (1. / 4294967296);
+	}
+
+	// Skips to dimension d, e.g. to keep the numbers of later bounces fixed.
+	void setDimension(uint32_t d) {
+		_dimension = d;
+
+		if (d & 3) hash(_pixel, _sample, d >> 2, _frame, _block);
+	}
+
+	static void hash(uint32_t x, uint32_t y, uint32_t z, uint32_t w, uint32_t out[4]) {
+		x = x * 1664525u + 1013904223u;
+		y = y * 1664525u + 1013904223u;
+		z = z * 1664525u + 1013904223u;
+		w = w * 1664525u + 1013904223u;
+
+		x += y * w; y += z * x; z += x * y; w += y * z;
+
+		x ^= x >> 16; y ^= y >> 16; z ^= z >> 16; w ^= w >> 16;
+
+		x += y * w; y += z * x; z += x * y; w += y * z;
+
+		out[0] = x;
+		out[1] = y;
+		out[2] = z;
+		out[3] = w;
+	}
+
+private:
+	uint32_t _pixel, _sample, _frame, _dimension;
+	uint32_t _block[4];
+};
@@ -23,6 +23,16 @@ public:
 	Ray3D(const Vector3D& origin, const Vector3D& direction)
 		: _origin(origin)
 		, _direction(direction)
+		, _coneWidth(0)
+		, _coneSpread(0)
+	{}
+
+	// A ray cone of width 'coneWidth' at the origin, widening by 'coneSpread' per unit distance.
+	Ray3D(const Vector3D& origin, const Vector3D& direction, double coneWidth, double coneSpread)
+		: _origin(origin)
+		, _direction(direction)
+		, _coneWidth(coneWidth)
+		, _coneSpread(coneSpread)
 	{}
 
 	Vector3D getPoint(double t) const { return (_direction*t) += _origin; }
@@ -31,7 +41,13 @@ public:
 
 	const Vector3D& getDirection() const { return _direction; }
 
+	// Width of the footprint at distance t, used to filter textures.
+	double getConeWidth(double t) const { return _coneWidth + _coneSpread*t; }
+
+	double getConeSpread() const { return _coneSpread; }
+
 private:
 	Vector3D _origin;
 	Vector3D _direction;
+	double _coneWidth, _coneSpread;
 };
\ No newline at end of file
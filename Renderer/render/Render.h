@@ -24,6 +24,11 @@
 #include "IdealMaterial.h"
 #include "UnionGeometry.h"
 #include "RandomLCG.h"
+#include "RandomPCG.h"
+#include "AOV.h"
+#include "Profiler.h"
+#include "Film.h"
+#include "ConcurrentFilm.h"
 
 #include <algorithm>
 #include <ctime>
@@ -53,17 +58,38 @@ public:
 
 	static Matrix<uint8> renderLight(const Geometry& scene, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera, const Size& size);
 
-	static Matrix<uint8> pathTrace(const Geometry& scene, const PerspectiveCamera& camera, int samples, const Size& size);
+	static Matrix<uint8> pathTrace(const Geometry& scene, const PerspectiveCamera& camera, int samples, const Size& size, AOV* aov = nullptr);
 
-	static Color pathTraceRecursive(const Geometry& scene, const Ray3D& ray, int depth, RandomLCG& rand);
+	static void pathTrace(const Geometry& scene, const PerspectiveCamera& camera, int samples, Film& film, int frame = 0);
+
+	static void pathTrace(const Geometry& scene, const PerspectiveCamera& camera, int samples, ConcurrentFilm& film, int frame = 0);
+
+	// RNG is any generator with double operator()() in [0, 1), e.g. RandomLCG or RandomPCG.
+	template<typename RNG>
+	static Color pathTraceRecursive(const Geometry& scene, const Ray3D& ray, int depth, RNG& rand);
+
+	// Row i of rayTrace, renderLight and the first pathTrace, into m of the full image size; for
+	// schedulers of their own, such as RenderQueue.
+	static void rayTraceRow(const Geometry& scene, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera, int maxReflect, Matrix<uint8>& m, int i);
+
+	static void rayTracePixel(const Geometry& scene, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera, int maxReflect, Matrix<uint8>& m, int i, int j);
+
+	static void renderLightRow(const Geometry& scene, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera, Matrix<uint8>& m, int i);
+
+	static void pathTraceRow(const Geometry& scene, const PerspectiveCamera& camera, int samples, Matrix<uint8>& m, int i, AOV* aov = nullptr);
 
 private:
+	template<typename Splat>
+	static void samplePixel(const Geometry& scene, const PerspectiveCamera& camera, int samples, int frame, int i, int j, int height, int width, Splat splat);
+
 	static Color rayTraceRecursive(const Geometry& scene, const vector<shared_ptr<Light>>& lights, const Ray3D& ray, int maxReflect);
 
 };
 
 
 Color Render::rayTraceRecursive(const Geometry& scene, const vector<shared_ptr<Light>>& lights, const Ray3D& ray, int maxReflect) {
+	Profiler::countRay();
+
 	const auto result = scene.intersect(ray);
 
 	if (result.getGeometry()) {
@@ -72,6 +98,8 @@ Color Render::rayTraceRecursive(const Geometry& scene, const vector<shared_ptr<L
 		Color clr;
 
 		for (auto& light : lights) {
+			Profiler::countShadowRay();
+
 			const LightSample lightSample = light->sample(scene, result.getPosition());
 			clr += material->sample(ray, lightSample, result.getPosition(), result.getNormal());
 		}
@@ -83,7 +111,8 @@ Color Render::rayTraceRecursive(const Geometry& scene, const vector<shared_ptr<L
 			const Vector3D& n = result.getNormal();
 			const Vector3D r = d - 2 * (d.dot(n)) * n;
 
-			const Color reflectedClr = rayTraceRecursive(scene, lights, Ray3D(result.getPosition(), r), maxReflect - 1);
+			const Ray3D reflectedRay(result.getPosition(), r, ray.getConeWidth(result.getDistance()), ray.getConeSpread());
+			const Color reflectedClr = rayTraceRecursive(scene, lights, reflectedRay, maxReflect - 1);
 			clr += reflectedClr * reflectiveness;
 		}
 
@@ -109,28 +138,33 @@ Color Render::rayTraceRecursive(const Geometry& scene, const vector<shared_ptr<L
 | note:        [10/28/2016 vodka]
 |-----------------------------------------------------------------------------------------*/
 Matrix<uint8> Render::rayTrace(const Geometry& scene, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera, int maxReflect, const Size& size) {
-	Matrix<uint8> m(size);
+	Matrix<uint8> m;
+	m.create(size.height(), size.width(), size.channel(), false);
 
 	const int height = m.height();
-	const int width = m.width();
 
 	#pragma omp parallel for
-	for (int i = 0; i < height; ++i) {
-		const double sy = 1 - i / double(height);
+	for (int i = 0; i < height; ++i)
+		rayTraceRow(scene, lights, camera, maxReflect, m, i);
 
-		for (int j = 0; j < width; ++j) {
-			const double sx = j / double(width);
-			const Ray3D ray = camera.generateRay(sx, sy);
-			const Color clr = rayTraceRecursive(scene, lights, ray, maxReflect);
 
-			m(i, j, 0) = convert(clr.r);
-			m(i, j, 1) = convert(clr.g);
-			m(i, j, 2) = convert(clr.b);
-		}
-	}
+	return std::move(m);
+}
 
+void Render::rayTraceRow(const Geometry& scene, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera, int maxReflect, Matrix<uint8>& m, int i) {
+	for (int j = 0; j < m.width(); ++j)
+		rayTracePixel(scene, lights, camera, maxReflect, m, i, j);
+}
 
-	return std::move(m);
+void Render::rayTracePixel(const Geometry& scene, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera, int maxReflect, Matrix<uint8>& m, int i, int j) {
+	const double sx = j / double(m.width());
+	const double sy = 1 - i / double(m.height());
+	const Ray3D ray = camera.generateRay(sx, sy, m.height());
+	const Color clr = rayTraceRecursive(scene, lights, ray, maxReflect);
+
+	m(i, j, 0) = convert(clr.r);
+	m(i, j, 1) = convert(clr.g);
+	m(i, j, 2) = convert(clr.b);
 }
 
 
@@ -150,50 +184,63 @@ Matrix<uint8> Render::rayTrace(const Geometry& scene, const vector<shared_ptr<Li
 Matrix<uint8> Render::renderLight(const Geometry& scene, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera, const Size& size) {
 	Matrix<uint8> m(size);
 
+	for (int i = 0; i < m.height(); ++i)
+		renderLightRow(scene, lights, camera, m, i);
+
+
+	return std::move(m);
+}
+
+void Render::renderLightRow(const Geometry& scene, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera, Matrix<uint8>& m, int i) {
 	const int height = m.height();
 	const int width = m.width();
+	const double sy = 1 - i / double(height);
 
-	for (int i = 0; i < height; ++i) {
-		const double sy = 1 - i / double(height);
+	for (int j = 0; j < width; ++j) {
+		const double sx = j / double(width);
+		const Ray3D ray = camera.generateRay(sx, sy);
 
-		for (int j = 0; j < width; ++j) {
-			const double sx = j / double(width);
-			const Ray3D ray = camera.generateRay(sx, sy);
-			const auto result = scene.intersect(ray);
+		Profiler::countRay();
 
-			if (result.getGeometry()) {
-				Color clr = Color::BLACK;
+		const auto result = scene.intersect(ray);
 
-				for (auto& light : lights) {
-					auto lightSample = light->sample(scene, result.getPosition());
+		if (result.getGeometry()) {
+			Color clr = Color::BLACK;
 
-					if (&lightSample != &LightSample::zero) {
-						double NdotL = result.getNormal().dot(lightSample.L());
+			for (auto& light : lights) {
+				Profiler::countShadowRay();
 
-						if (NdotL >= 0) {
-							clr += lightSample.EL() * NdotL;
-						}
+				auto lightSample = light->sample(scene, result.getPosition());
+
+				if (&lightSample != &LightSample::zero) {
+					double NdotL = result.getNormal().dot(lightSample.L());
+
+					if (NdotL >= 0) {
+						clr += lightSample.EL() * NdotL;
 					}
 				}
-
-				m(i, j, 0) = convert(clr.r);
-				m(i, j, 1) = convert(clr.g);
-				m(i, j, 2) = convert(clr.b);
 			}
+
+			m(i, j, 0) = convert(clr.r);
+			m(i, j, 1) = convert(clr.g);
+			m(i, j, 2) = convert(clr.b);
 		}
 	}
-
-
-	return std::move(m);
 }
 
 
 
-Color Render::pathTraceRecursive(const Geometry& scene, const Ray3D& ray, int depth, RandomLCG& rand) {
+template<typename RNG>
+Color Render::pathTraceRecursive(const Geometry& scene, const Ray3D& ray, int depth, RNG& rand) {
+	Profiler::countRay();
+
 	IntersectResult&& result = scene.intersect(ray);
 
 	// if miss, return black.
-	if (result.getGeometry() == nullptr) return Color::BLACK;
+	if (result.getGeometry() == nullptr) {
+		Profiler::countPathEnd(depth);
+		return Color::BLACK;
+	}
 
 	const auto& material = result.getGeometry()->getMaterial();
 	const Color& emission = material->getEmission();
@@ -208,7 +255,12 @@ Color Render::pathTraceRecursive(const Geometry& scene, const Ray3D& ray, int de
 	const bool isUseRR = newDepth > 5;
 	const bool isRR = isUseRR && rand() < maxC;
 
-	if (isMaxDepth || (isUseRR && !isRR)) return emission;
+	if (isMaxDepth || (isUseRR && !isRR)) {
+		if (!isMaxDepth) Profiler::countRouletteKill();
+
+		Profiler::countPathEnd(newDepth);
+		return emission;
+	}
 
 	Color f = (isUseRR && isRR) ? color * (1.0 / maxC) : color;
 	const Vector3D& x = result.getPosition();
@@ -280,48 +332,208 @@ Color Render::pathTraceRecursive(const Geometry& scene, const Ray3D& ray, int de
 |              @param camera:
 |              @param samples:
 |              @param size:
+|              @param aov: if not null, receives the colour and first-hit buffers.
 |
 | blog:        http://www.cnblogs.com/miloyip/archive/2010/04/02/1702768.html
 | note:        [10/28/2016 vodka]
 |-----------------------------------------------------------------------------------------*/
-Matrix<uint8> Render::pathTrace(const Geometry& scene, const PerspectiveCamera& camera, int samples, const Size& size) {
-	Matrix<uint8> m(size);
+Matrix<uint8> Render::pathTrace(const Geometry& scene, const PerspectiveCamera& camera, int samples, const Size& size, AOV* aov) {
+	Matrix<uint8> m;
+	m.create(size.height(), size.width(), size.channel(), false);
 
 	const int height = m.height();
 	const int width = m.width();
 
+	if (aov) aov->create(height, width);
+
 #pragma omp parallel for schedule(dynamic, 1)
 	for (int i = 0; i < height; ++i) {
 		fprintf(stderr,"\rRendering (%dx4 = %d spp) %5.2f%%", samples, samples*4, 100.*i/(height-1));
 
-		RandomLCG rand(i);
+		pathTraceRow(scene, camera, samples, m, i, aov);
+	}
 
-		for (int j = 0; j < width; ++j) {
-			Color clr, sum;
 
- 			for (int sy = 0; sy < 2; ++sy) {
- 				for (int sx = 0; sx < 2; ++sx) {
- 					for (int s = 0; s < samples; ++s) {
- 						double r1 = 2 * rand();
- 						double r2 = 2 * rand();
- 						double dx = r1 < 1 ? std::sqrt(r1) - 1 : 1 - std::sqrt(2 - r1);
- 						double dy = r2 < 1 ? std::sqrt(r2) - 1 : 1 - std::sqrt(2 - r2);
- 
- 						const Ray3D ray = camera.generateRay(((sx + 0.5 + dx) * 0.5 + j) / width, ((sy + 0.5 + dy) * 0.5 + height - 1 - i) / height);
- 						
- 						clr += pathTraceRecursive(scene, ray, 0, rand) * (1.0 / samples);
- 					}
+	return std::move(m);
+}
+
+void Render::pathTraceRow(const Geometry& scene, const PerspectiveCamera& camera, int samples, Matrix<uint8>& m, int i, AOV* aov) {
+	const int height = m.height();
+	const int width = m.width();
+
+	RandomLCG rand(i);
+	const uint64_t rowStart = Profiler::now();
+
+	for (int j = 0; j < width; ++j) {
+		const uint64_t pixelStart = Profiler::enabled() ? Profiler::now() : 0;
+		Color clr, sum, radiance;
+
+ 		for (int sy = 0; sy < 2; ++sy) {
+ 			for (int sx = 0; sx < 2; ++sx) {
+ 				for (int s = 0; s < samples; ++s) {
+ 					double r1 = 2 * rand();
+ 					double r2 = 2 * rand();
+ 					double dx = r1 < 1 ? std::sqrt(r1) - 1 : 1 - std::sqrt(2 - r1);
+ 					double dy = r2 < 1 ? std::sqrt(r2) - 1 : 1 - std::sqrt(2 - r2);
  
- 					sum += Color(Math::clip(clr.r, .0, 1.0), Math::clip(clr.g, .0, 1.0), Math::clip(clr.b, .0, 1.0)) * .25;
+ 					const Ray3D ray = camera.generateRay(((sx + 0.5 + dx) * 0.5 + j) / width, ((sy + 0.5 + dy) * 0.5 + height - 1 - i) / height);
+ 					
+ 					const Color sample = pathTraceRecursive(scene, ray, 0, rand) * (1.0 / samples);
+ 					clr += sample;
+ 					radiance += sample * .25;
  				}
+ 
+ 				sum += Color(Math::clip(clr.r, .0, 1.0), Math::clip(clr.g, .0, 1.0), Math::clip(clr.b, .0, 1.0)) * .25;
  			}
+ 		}
+
+		m(i, j, 0) = convert(sum.r);
+		m(i, j, 1) = convert(sum.g);
+		m(i, j, 2) = convert(sum.b);
 
-			m(i, j, 0) = convert(sum.r);
-			m(i, j, 1) = convert(sum.g);
-			m(i, j, 2) = convert(sum.b);
+		if (pixelStart) Profiler::recordPixel(i, j, Profiler::now() - pixelStart);
+
+		if (aov) {
+			const Ray3D ray = camera.generateRay((j + 0.5) / width, (height - 0.5 - i) / height);
+			const auto result = scene.intersect(ray);
+			const Geometry* geometry = result.getGeometry();
+
+			aov->color(i, j, 0) = (float)radiance.r;
+			aov->color(i, j, 1) = (float)radiance.g;
+			aov->color(i, j, 2) = (float)radiance.b;
+
+			if (geometry) {
+				const Color& albedo = geometry->getMaterial()->getColor();
+				const Vector3D& n = result.getNormal();
+				const Vector3D nl = n.dot(ray.getDirection()) < 0 ? n : n * -1;
+
+				aov->albedo(i, j, 0) = (float)albedo.r;
+				aov->albedo(i, j, 1) = (float)albedo.g;
+				aov->albedo(i, j, 2) = (float)albedo.b;
+				aov->normal(i, j, 0) = (float)nl.x();
+				aov->normal(i, j, 1) = (float)nl.y();
+				aov->normal(i, j, 2) = (float)nl.z();
+				aov->depth(i, j) = (float)result.getDistance();
+				aov->id(i, j) = geometry->getId();
+			}
+			else {
+				for (int k = 0; k < 3; ++k) {
+					aov->albedo(i, j, k) = 0;
+					aov->normal(i, j, k) = 0;
+				}
+
+				aov->depth(i, j) = 0;
+				aov->id(i, j) = -1;
+			}
 		}
 	}
 
+	Profiler::recordTile(i, 0, 1, width, rowStart, Profiler::now());
+}
 
-	return std::move(m);
+
+/*------------------------------------------------------------------------------------------/
+| function:    pathTrace
+| description:
+|              The same, reconstructed by the filter of the film. Every pixel takes samples*4
+|              samples, jittered in a 2x2 grid, and every sample reaches all pixels within the
+|              filter radius. Tiles are rendered in parallel and merged into the film.
+|
+| input:       @param scene:
+|              @param camera:
+|              @param samples:
+|              @param film: output; samples are added to what it holds.
+|              @param frame: keys the random numbers; passes of a progressive render differ in it.
+|
+| return:      none
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+void Render::pathTrace(const Geometry& scene, const PerspectiveCamera& camera, int samples, Film& film, int frame) {
+	const int height = film.height();
+	const int width = film.width();
+
+	const int tileSize = 16;
+	const int tilesX = (width + tileSize - 1) / tileSize;
+	const int tilesY = (height + tileSize - 1) / tileSize;
+	const int tiles = tilesX * tilesY;
+
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int t = 0; t < tiles; ++t) {
+		fprintf(stderr, "\rRendering (%dx4 = %d spp) %5.2f%%", samples, samples * 4, 100.*t / std::max(tiles - 1, 1));
+
+		const int top = t / tilesX * tileSize;
+		const int left = t % tilesX * tileSize;
+		const int bottom = std::min(top + tileSize, height);
+		const int right = std::min(left + tileSize, width);
+		const uint64_t start = Profiler::now();
+
+		FilmTile tile = film.makeTile(top, left, bottom - top, right - left);
+
+		for (int i = top; i < bottom; ++i)
+			for (int j = left; j < right; ++j)
+				samplePixel(scene, camera, samples, frame, i, j, height, width, [&](double x, double y, const Color& radiance) { tile.addSample(x, y, radiance); });
+
+		film.mergeTile(tile);
+
+		Profiler::recordTile(top, left, bottom - top, right - left, start, Profiler::now());
+	}
+}
+
+
+/*------------------------------------------------------------------------------------------/
+| function:    pathTrace
+| description:
+|              The same into a film shared by all threads: rows are handed out one at a time
+|              and every thread adds its samples straight to the film.
+|
+| input:       @param scene:
+|              @param camera:
+|              @param samples:
+|              @param film: output; samples are added to what it holds.
+|              @param frame: keys the random numbers; passes of a progressive render differ in it.
+|
+| return:      none
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+void Render::pathTrace(const Geometry& scene, const PerspectiveCamera& camera, int samples, ConcurrentFilm& film, int frame) {
+	const int height = film.height();
+	const int width = film.width();
+
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int i = 0; i < height; ++i) {
+		fprintf(stderr, "\rRendering (%dx4 = %d spp) %5.2f%%", samples, samples * 4, 100.*i / std::max(height - 1, 1));
+
+		const uint64_t start = Profiler::now();
+
+		for (int j = 0; j < width; ++j)
+			samplePixel(scene, camera, samples, frame, i, j, height, width, [&](double x, double y, const Color& radiance) { film.addSample(x, y, radiance); });
+
+		Profiler::recordTile(i, 0, 1, width, start, Profiler::now());
+	}
+}
+
+
+// Takes the samples*4 samples of pixel (i, j), jittered in a 2x2 grid, and passes each one
+// to splat(x, y, radiance) with its position in pixels. The random numbers of a sample depend
+// only on its pixel, its index and the frame, so the result does not depend on scheduling.
+template<typename Splat>
+void Render::samplePixel(const Geometry& scene, const PerspectiveCamera& camera, int samples, int frame, int i, int j, int height, int width, Splat splat) {
+	const uint64_t start = Profiler::enabled() ? Profiler::now() : 0;
+
+	for (int sy = 0; sy < 2; ++sy) {
+		for (int sx = 0; sx < 2; ++sx) {
+			for (int s = 0; s < samples; ++s) {
+				RandomPCG rand(i * width + j, (sy * 2 + sx) * samples + s, frame);
+
+				const double x = j + (sx + rand()) * 0.5;
+				const double y = i + (sy + rand()) * 0.5;
+
+				const Ray3D ray = camera.generateRay(x / width, (height - y) / height);
+
+				splat(x, y, pathTraceRecursive(scene, ray, 0, rand));
+			}
+		}
+	}
+
+	if (start) Profiler::recordPixel(i, j, Profiler::now() - start);
 }
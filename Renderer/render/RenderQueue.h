@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     RenderQueue.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Asynchronous render jobs on a ThreadPool.
+//
+//                submit() splits a job into one task per row and returns at once with a future of
+//                the image. The rows of all submitted jobs share the pool, so frames overlap and the
+//                last rows of one frame run beside the first rows of the next.
+//
+//                A job keeps its scene and lights alive until its last row is done. It reports
+//                progress from the worker threads and may be cancelled at any time; rows not yet
+//                started are skipped and the future then throws.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Render.h"
+#include "ThreadPool.h"
+#include "MyException.h"
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+
+class RenderJob {
+public:
+	enum Method { PATH_TRACE, RAY_TRACE, RENDER_LIGHT };
+
+	static RenderJob pathTrace(const shared_ptr<const Geometry>& scene, const PerspectiveCamera& camera, int samples, const Size& size);
+
+	static RenderJob rayTrace(const shared_ptr<const Geometry>& scene, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera, int maxReflect, const Size& size);
+
+	static RenderJob renderLight(const shared_ptr<const Geometry>& scene, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera, const Size& size);
+
+	// Rows of jobs of higher priority are started first.
+	int priority = 0;
+
+	// Fraction of the rows done, in (0, 1] and increasing; called from the worker threads, one
+	// at a time, so it must be short.
+	std::function<void(double)> progress;
+
+	// Shared by the copies of the job, so the job can be cancelled through the one it was
+	// submitted from.
+	void cancel() const { *_cancelled = true; }
+
+	bool cancelled() const { return *_cancelled; }
+
+private:
+	RenderJob(Method method, const shared_ptr<const Geometry>& scene, const PerspectiveCamera& camera, const Size& size)
+		: _method(method)
+		, _scene(scene)
+		, _camera(camera)
+		, _size(size)
+		, _cancelled(std::make_shared<std::atomic<bool>>(false)) {
+	}
+
+	friend class RenderQueue;
+
+	Method _method;
+	shared_ptr<const Geometry> _scene;
+	vector<shared_ptr<Light>> _lights;
+	PerspectiveCamera _camera;
+	Size _size;
+	int _samples = 1;
+	int _maxReflect = 0;
+	shared_ptr<std::atomic<bool>> _cancelled;
+};
+
+class RenderQueue {
+public:
+
+	explicit RenderQueue(ThreadPool& pool = ThreadPool::instance()) : _pool(pool) {}
+
+	std::future<Matrix<uint8>> submit(const RenderJob& job);
+
+	ThreadPool& pool() { return _pool; }
+
+private:
+	struct State {
+		RenderJob job;
+		Matrix<uint8> image;
+		std::atomic<int> remaining;
+		std::promise<Matrix<uint8>> promise;
+		std::exception_ptr error;
+		int reported;  // rows done at the last progress call
+		std::mutex mutex;
+
+		explicit State(const RenderJob& job) : job(job), remaining(0), reported(0) {}
+	};
+
+	static void renderRow(State& state, int i);
+
+	ThreadPool& _pool;
+};
+
+
+RenderJob RenderJob::pathTrace(const shared_ptr<const Geometry>& scene, const PerspectiveCamera& camera, int samples, const Size& size) {
+	RenderJob job(PATH_TRACE, scene, camera, size);
+	job._samples = samples;
+
+	return job;
+}
+
+RenderJob RenderJob::rayTrace(const shared_ptr<const Geometry>& scene, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera, int maxReflect, const Size& size) {
+	RenderJob job(RAY_TRACE, scene, camera, size);
+	job._lights = lights;
+	job._maxReflect = maxReflect;
+
+	return job;
+}
+
+RenderJob RenderJob::renderLight(const shared_ptr<const Geometry>& scene, const vector<shared_ptr<Light>>& lights, const PerspectiveCamera& camera, const Size& size) {
+	RenderJob job(RENDER_LIGHT, scene, camera, size);
+	job._lights = lights;
+
+	return job;
+}
+
+
+/*------------------------------------------------------------------------------------------/
+| function:    submit
+| description:
+|              Queue the rows of a job on the pool.
+|
+| input:       @param job: the job, copied; cancel it through this or any other copy.
+|
+| return:      the image, or an exception if the job was cancelled or a row threw; throws at
+|              once if the image is empty
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+std::future<Matrix<uint8>> RenderQueue::submit(const RenderJob& job) {
+	const Size& size = job._size;
+
+	if (size.height() <= 0 || size.width() <= 0 || size.channel() <= 0)
+		throw Exception("Render job of an empty image!");
+
+	auto state = std::make_shared<State>(job);
+	auto future = state->promise.get_future();
+
+	state->image.create(size.height(), size.width(), size.channel(), true);
+
+	const int height = size.height();
+	state->remaining = height;
+
+	for (int i = 0; i < height; ++i)
+		_pool.submit([state, i]() { renderRow(*state, i); }, job.priority);
+
+	return future;
+}
+
+void RenderQueue::renderRow(State& state, int i) {
+	const RenderJob& job = state.job;
+
+	if (!job.cancelled()) {
+		try {
+			switch (job._method) {
+			case RenderJob::PATH_TRACE:
+				Render::pathTraceRow(*job._scene, job._camera, job._samples, state.image, i);
+				break;
+			case RenderJob::RAY_TRACE:
+				Render::rayTraceRow(*job._scene, job._lights, job._camera, job._maxReflect, state.image, i);
+				break;
+			case RenderJob::RENDER_LIGHT:
+				Render::renderLightRow(*job._scene, job._lights, job._camera, state.image, i);
+				break;
+			}
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(state.mutex);
+			if (!state.error) state.error = std::current_exception();
+			job.cancel();
+		}
+	}
+
+	const int height = state.image.height();
+	const int remaining = --state.remaining;
+
+	// Rows finish out of order, so a row that lost the race to a later count reports nothing.
+	if (job.progress && !job.cancelled()) {
+		std::lock_guard<std::mutex> lock(state.mutex);
+
+		if (height - remaining > state.reported) {
+			state.reported = height - remaining;
+			job.progress(double(state.reported) / height);
+		}
+	}
+
+	if (remaining > 0) return;
+
+	if (state.error)
+		state.promise.set_exception(state.error);
+	else if (job.cancelled())
+		state.promise.set_exception(std::make_exception_ptr(Exception("Render job cancelled!")));
+	else
+		state.promise.set_value(std::move(state.image));
+}
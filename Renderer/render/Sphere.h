@@ -35,6 +35,14 @@ public:
 
 	virtual pair<Vector3D, Vector3D> calcPositionAndNormal(const Ray3D& ray, double distance) const;
 
+	virtual AABB getBounds() const { return AABB(_center - Vector3D(_radius, _radius, _radius), _center + Vector3D(_radius, _radius, _radius)); }
+
+	const Vector3D& getCenter() const { return _center; }
+
+	double getRadius() const { return _radius; }
+
+	void setCenter(const Vector3D& center) { _center = center; }
+
 private:
 	Vector3D _center;
 	double _radius, _sqrRadius;
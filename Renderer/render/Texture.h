@@ -0,0 +1,28 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     Texture.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Abstract image texture.
+//
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Color.h"
+
+class Texture {
+public:
+
+	virtual ~Texture(){}
+
+	// Colour around (u, v), filtered over a footprint 'width' wide, all in texture space where the
+	// image spans [0, 1) and repeats.
+	virtual Color lookup(double u, double v, double width) const = 0;
+};
@@ -0,0 +1,312 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     TextureCache.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Texture tiles loaded on demand into a bounded memory pool.
+//
+//                Textures are binary PPM / PGM files, read one square tile at a time with
+//                PXMImage::openRegion. A tile holds its own mip chain down to 1x1, so filtered
+//                lookups never need the whole image. Tiles are kept in one pool shared by all
+//                threads; when it grows past its byte limit the least recently used tiles are
+//                dropped. Every thread also remembers the last few tiles it used, so hits on them
+//                take no lock.
+//
+//                A tile dropped from the pool lives on while some thread still remembers it, so the
+//                memory in use may exceed the limit by up to localSlots tiles per thread.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "PXMImage.h"
+#include "Matrix.h"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class TextureCache {
+public:
+
+	struct Statistics {
+		uint64_t hits;       // texels read from memory
+		uint64_t misses;     // tiles read from a file
+		uint64_t evictions;  // tiles dropped from the pool
+		size_t bytes;        // memory held by the pool
+	};
+
+	// 'maxBytes' bounds the memory of the pool; tiles are 2^tileBits texels wide.
+	explicit TextureCache(size_t maxBytes, int tileBits = 6);
+
+	// Registers a texture file and returns its id. Only its header is read.
+	int add(const string& filepath);
+
+	Size size(int texture) const;
+
+	int tileBits() const { return _tileBits; }
+
+	int tileSize() const { return 1 << _tileBits; }
+
+	// Texel (x, y) of 'level' inside 'tile' of 'texture', as RGB. Tiles are numbered row by row,
+	// and x, y are less than tileSize() >> level.
+	void texel(int texture, int tile, int level, int x, int y, uint8 rgb[3]);
+
+	// Hits are published by every thread in batches, so a running count may lag a little.
+	Statistics statistics() const;
+
+private:
+	// One row with all levels of the mip chain, 3 channels. Not pooled: an evicted tile must give
+	// its memory back rather than park it in the pool of whichever thread dropped it.
+	typedef Matrix<uint8, AlignedAllocator> Tile;
+
+	struct TextureInfo {
+		string filepath;
+		int height, width, tilesX;
+	};
+
+	struct Counters {
+		std::atomic<uint64_t> hits, misses, evictions;
+
+		Counters() : hits(0), misses(0), evictions(0) {}
+	};
+
+	struct Entry {
+		uint64_t key;
+		std::shared_ptr<const Tile> tile;
+	};
+
+	static const int localSlots = 16;  // indexed by the top 4 bits of a key hash
+	static const int hitBatch = 256;
+
+	// Recently used tiles of one thread, for whichever cache it used last.
+	struct LocalCache {
+		uint64_t owner = 0;
+		uint64_t keys[localSlots];
+		std::shared_ptr<const Tile> tiles[localSlots];
+
+		// hits not yet added to 'counters'
+		std::shared_ptr<Counters> counters;
+		uint64_t hits = 0;
+	};
+
+	static LocalCache& local() {
+		thread_local LocalCache cache;
+		return cache;
+	}
+
+	static uint64_t nextId() {
+		static std::atomic<uint64_t> id(0);
+		return ++id;
+	}
+
+	static uint64_t makeKey(int texture, int tile) { return (uint64_t)texture << 32 | (uint32_t)tile; }
+
+	static void flushHits(LocalCache& cache) {
+		if (cache.counters) cache.counters->hits += cache.hits;
+		cache.hits = 0;
+	}
+
+	const Tile& findTile(int texture, int tile);
+
+	std::shared_ptr<const Tile> loadTile(const TextureInfo& info, int tile) const;
+
+	int levelOffset(int level) const { return _levelOffset[level]; }
+
+private:
+	const uint64_t _id;
+	const int _tileBits;
+	const size_t _maxBytes;
+	size_t _tileBytes;
+
+	std::vector<int> _levelOffset;
+
+	mutable std::mutex _mutex;
+	std::vector<TextureInfo> _textures;
+	std::list<Entry> _lru;  // most recently used first
+	std::unordered_map<uint64_t, std::list<Entry>::iterator> _index;
+	size_t _bytes;
+
+	std::shared_ptr<Counters> _counters;
+};
+
+
+TextureCache::TextureCache(size_t maxBytes, int tileBits)
+	: _id(nextId())
+	, _tileBits(tileBits)
+	, _maxBytes(maxBytes)
+	, _bytes(0)
+	, _counters(std::make_shared<Counters>()) {
+	assert(tileBits >= 0 && tileBits < 16);
+
+	int offset = 0;
+
+	for (int level = 0; level <= tileBits; ++level) {
+		_levelOffset.push_back(offset);
+		offset += (1 << (tileBits - level)) * (1 << (tileBits - level));
+	}
+
+	_tileBytes = (size_t)offset * 3;
+}
+
+int TextureCache::add(const string& filepath) {
+	const Size size = PXMImage::openSize(filepath);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_textures.push_back(TextureInfo{ filepath, size.height(), size.width(), (size.width() + tileSize() - 1) >> _tileBits });
+
+	return (int)_textures.size() - 1;
+}
+
+Size TextureCache::size(int texture) const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return Size(_textures[texture].height, _textures[texture].width, 3);
+}
+
+TextureCache::Statistics TextureCache::statistics() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return Statistics{ _counters->hits, _counters->misses, _counters->evictions, _bytes };
+}
+
+void TextureCache::texel(int texture, int tile, int level, int x, int y, uint8 rgb[3]) {
+	assert(level >= 0 && level <= _tileBits);
+
+	const int size = tileSize() >> level;
+	const uint8* p = &findTile(texture, tile)(0, levelOffset(level) + y*size + x);
+
+	rgb[0] = p[0];
+	rgb[1] = p[1];
+	rgb[2] = p[2];
+}
+
+
+const TextureCache::Tile& TextureCache::findTile(int texture, int tile) {
+	LocalCache& cache = local();
+	const uint64_t key = makeKey(texture, tile);
+	const int slot = (int)((key * 0x9E3779B97F4A7C15ull) >> 60);
+
+	if (cache.owner == _id && cache.keys[slot] == key) {
+		if (++cache.hits >= hitBatch) flushHits(cache);
+
+		return *cache.tiles[slot];
+	}
+
+	if (cache.owner != _id) {
+		flushHits(cache);
+
+		cache.owner = _id;
+		cache.counters = _counters;
+
+		for (int i = 0; i < localSlots; ++i) {
+			cache.keys[i] = ~0ull;
+			cache.tiles[i].reset();
+		}
+	}
+
+	std::shared_ptr<const Tile> found;
+	TextureInfo info;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _index.find(key);
+
+		if (it != _index.end()) {
+			_lru.splice(_lru.begin(), _lru, it->second);
+			found = it->second->tile;
+		}
+		else {
+			info = _textures[texture];
+		}
+	}
+
+	if (found) {
+		++cache.hits;
+	}
+	else {
+		// Read the file without holding the lock; another thread may load the same tile meanwhile.
+		std::shared_ptr<const Tile> loaded = loadTile(info, tile);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _index.find(key);
+
+		if (it != _index.end()) {
+			_lru.splice(_lru.begin(), _lru, it->second);
+			found = it->second->tile;
+		}
+		else {
+			found = loaded;
+			_lru.push_front(Entry{ key, loaded });
+			_index[key] = _lru.begin();
+			_bytes += _tileBytes;
+
+			while (_bytes > _maxBytes && _lru.size() > 1) {
+				_index.erase(_lru.back().key);
+				_lru.pop_back();
+				_bytes -= _tileBytes;
+				++_counters->evictions;
+			}
+		}
+
+		++_counters->misses;
+	}
+
+	cache.keys[slot] = key;
+	cache.tiles[slot] = found;
+
+	return *found;
+}
+
+std::shared_ptr<const TextureCache::Tile> TextureCache::loadTile(const TextureInfo& info, int tile) const {
+	const int size = tileSize();
+	const int top = tile / info.tilesX * size;
+	const int left = tile % info.tilesX * size;
+	const int height = std::min(size, info.height - top);
+	const int width = std::min(size, info.width - left);
+
+	const Matrix<uint8> region = PXMImage::openRegion(info.filepath, top, left, height, width);
+
+	auto result = std::make_shared<Tile>();
+	Tile& t = *result;
+
+	t.create(1, (int)(_tileBytes / 3), 3, false);
+
+	// Tiles on the right and bottom borders are padded with their edge texels.
+	for (int i = 0; i < size; ++i)
+		for (int j = 0; j < size; ++j)
+			for (int k = 0; k < 3; ++k)
+				t(0, i*size + j, k) = region(std::min(i, height - 1), std::min(j, width - 1), k);
+
+	for (int level = 1; level <= _tileBits; ++level) {
+		const int n = size >> level;
+		const uint8* src = &t(0, levelOffset(level - 1));
+		uint8* dst = &t(0, levelOffset(level));
+
+		for (int i = 0; i < n; ++i) {
+			for (int j = 0; j < n; ++j) {
+				for (int k = 0; k < 3; ++k) {
+					const int a = src[((2 * i) * 2 * n + 2 * j) * 3 + k];
+					const int b = src[((2 * i) * 2 * n + 2 * j + 1) * 3 + k];
+					const int c = src[((2 * i + 1) * 2 * n + 2 * j) * 3 + k];
+					const int d = src[((2 * i + 1) * 2 * n + 2 * j + 1) * 3 + k];
+
+					dst[(i*n + j) * 3 + k] = (uint8)((a + b + c + d + 2) >> 2);
+				}
+			}
+		}
+	}
+
+	return result;
+}
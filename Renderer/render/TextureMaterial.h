@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     TextureMaterial.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Lambert material whose colour comes from a texture.
+//
+//                The texture is projected onto the plane of the two axes closest to the surface,
+//                'scale' repeats per unit length. Each lookup is filtered over the width of the
+//                ray cone where it hits, so distant and grazing surfaces do not alias.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Material.h"
+#include "Texture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+class TextureMaterial : public Material {
+public:
+
+	TextureMaterial(const std::shared_ptr<Texture>& texture, double scale, double reflectiveness = 0)
+		: Material(0, reflectiveness)
+		, _texture(texture)
+		, _scale(scale)
+	{}
+
+	virtual Color sample(const Ray3D& ray, const LightSample& lightSample, const Vector3D& position, const Vector3D& normal) const;
+
+private:
+	std::shared_ptr<Texture> _texture;
+	double _scale;
+};
+
+
+Color TextureMaterial::sample(const Ray3D& ray, const LightSample& lightSample, const Vector3D& position, const Vector3D& normal) const {
+	const double ax = std::abs(normal.x()), ay = std::abs(normal.y()), az = std::abs(normal.z());
+
+	double u, v;
+
+	if (ax >= ay && ax >= az) {
+		u = position.y(); v = position.z();
+	}
+	else if (ay >= az) {
+		u = position.x(); v = position.z();
+	}
+	else {
+		u = position.x(); v = position.y();
+	}
+
+	// The cone is stretched along the surface as it tilts away from the ray.
+	const double distance = (position - ray.getOrigin()).length();
+	const double cosine = std::max(std::abs(normal.dot(ray.getDirection())), 0.1);
+	const double width = ray.getConeWidth(distance) * _scale / cosine;
+
+	const Color texel = _texture->lookup(u * _scale, v * _scale, width);
+	const double NdotL = normal.dot(lightSample.L());
+
+	return lightSample.EL().modulate(texel * std::max(NdotL, 0.0));
+}
@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     ThreadPool.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Long lived worker threads taking tasks from one priority queue.
+//
+//                Tasks of higher priority run first, tasks of equal priority in the order they were
+//                submitted. Work of several callers shares the queue, so the tasks of one job start
+//                as soon as threads are freed by the last tasks of another, with no fork / join in
+//                between.
+//
+//                The destructor lets running tasks finish, drops the queued ones and joins the
+//                threads.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+
+	// 0 threads: one per hardware thread.
+	explicit ThreadPool(int threads = 0);
+
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+
+	ThreadPool& operator = (const ThreadPool&) = delete;
+
+	int size() const { return (int)_threads.size(); }
+
+	void submit(const std::function<void()>& task, int priority = 0);
+
+	// Tasks queued and not started.
+	int pending() const;
+
+	// Shared by the whole process, created on first use.
+	static ThreadPool& instance() {
+		static ThreadPool pool;
+		return pool;
+	}
+
+private:
+	struct Task {
+		int priority;
+		uint64_t sequence;
+		std::function<void()> run;
+
+		// Lowest first out of std::priority_queue: lower priority, then later submission.
+		bool operator < (const Task& rhs) const {
+			return priority != rhs.priority ? priority < rhs.priority : sequence > rhs.sequence;
+		}
+	};
+
+	void work();
+
+private:
+	std::vector<std::thread> _threads;
+	std::priority_queue<Task> _tasks;
+	uint64_t _sequence;
+	bool _stop;
+
+	mutable std::mutex _mutex;
+	std::condition_variable _ready;
+};
+
+
+ThreadPool::ThreadPool(int threads)
+	: _sequence(0)
+	, _stop(false)
+{
+	if (threads <= 0) threads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	for (int i = 0; i < threads; ++i)
+		_threads.emplace_back([this]() { work(); });
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+
+	_ready.notify_all();
+
+	for (auto& thread : _threads)
+		thread.join();
+}
+
+void ThreadPool::submit(const std::function<void()>& task, int priority) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_tasks.push(Task{ priority, _sequence++, task });
+	}
+
+	_ready.notify_one();
+}
+
+int ThreadPool::pending() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return (int)_tasks.size();
+}
+
+void ThreadPool::work() {
+	while (true) {
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_ready.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+
+			if (_stop) return;
+
+			task = _tasks.top().run;
+			_tasks.pop();
+		}
+
+		task();
+	}
+}
@@ -0,0 +1,408 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     UniformGrid.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Uniform grid over the bounds of the geometry, with an optional second level.
+//
+//                The resolution puts 'density' geometries per cell on average, in cells as close to
+//                cubes as the bounds allow. Every geometry is listed in all the cells its box
+//                overlaps; the lists are built by counting sort in two passes over the geometry, so
+//                the build is linear. A cell of the top level listing more than 'subdivide'
+//                geometries gets its own grid, over the part of the cell they fill, when that separates
+//                them.
+//
+//                A ray walks the cells it crosses in order, by 3D-DDA, without a stack, and stops at
+//                the first cell that ends behind its nearest hit. A geometry listed in several cells
+//                may be tested once per cell.
+//
+//                Geometry without bounds, such as planes, is kept out of the grid and tested by
+//                every ray.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Geometry.h"
+#include "AABB.h"
+#include "Profiler.h"
+#include "MyException.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+using std::vector;
+using std::shared_ptr;
+
+class UniformGrid : public Geometry {
+public:
+	UniformGrid(const vector<shared_ptr<Geometry>>& geometries, double density = 2, int subdivide = 16);
+
+	UniformGrid(const UniformGrid&) = delete;
+
+	UniformGrid& operator = (const UniformGrid&) = delete;
+
+	virtual IntersectResult intersect(const Ray3D& ray) const;
+
+	virtual double calcDistance(const Ray3D& ray) const { throw Exception("Illegal function call: 'UniformGrid' is an abstract class!"); }
+
+	virtual pair<Vector3D, Vector3D> calcPositionAndNormal(const Ray3D& ray, double distance) const { throw Exception("Illegal function call: 'UniformGrid' is an abstract class!"); }
+
+	virtual AABB getBounds() const { return _unbounded.empty() ? _bounds : AABB::infinite(); }
+
+	// Cells per axis of the top level.
+	int resolution(int axis) const { return _resolution[axis]; }
+
+	// Cells of both levels, and geometries listed in them.
+	size_t cells() const;
+
+	size_t references() const;
+
+	// The resolution of 'count' geometries within 'bounds' for 'density' per cell.
+	static void resolution(const AABB& bounds, size_t count, double density, int resolution[3]);
+
+private:
+	UniformGrid(const vector<AABB>& boxes, const vector<int>& items, const AABB& bounds, double density);
+
+	void build(const vector<AABB>& boxes, const vector<int>& items, double density);
+
+	// Cells [lo, hi] per axis that 'box' overlaps.
+	void cellRange(const AABB& box, int lo[3], int hi[3]) const;
+
+	int cellIndex(int x, int y, int z) const { return (z * _resolution[1] + y) * _resolution[0] + x; }
+
+	// Walks the segment [tmin, tmax] of the ray.
+	void traverse(const Ray3D& ray, double tmin, double tmax, double& minDist, const Geometry*& nearest) const;
+
+private:
+	AABB _bounds;
+	int _resolution[3];
+	Vector3D _cellSize;
+
+	// Geometries of a cell: _items[begin, begin + count), indices into _primitives of the top level.
+	// A cell with a grid of its own has count -1 - the index of the grid, in _grids.
+	struct Cell {
+		int begin;
+		int count;
+	};
+
+	vector<Cell> _cells;
+	vector<int> _items;
+	vector<std::unique_ptr<UniformGrid>> _grids;
+
+	vector<shared_ptr<Geometry>> _primitives;
+	vector<shared_ptr<Geometry>> _unbounded;
+
+	// The geometries of a second level grid are those of its parent.
+	const vector<shared_ptr<Geometry>>* _geometries;
+
+	// Cells per axis of any level, which keeps a few unbalanced bounds from using all memory.
+	static const int maxResolution = 512;
+};
+
+// Bound by reference in std::min, so it needs a definition.
+const int UniformGrid::maxResolution;
+
+
+UniformGrid::UniformGrid(const vector<shared_ptr<Geometry>>& geometries, double density, int subdivide)
+	: _geometries(&_primitives) {
+	_resolution[0] = _resolution[1] = _resolution[2] = 0;
+
+	vector<AABB> boxes;
+
+	for (auto& geometry : geometries) {
+		const AABB bounds = geometry->getBounds();
+
+		if (!bounds.isFinite()) {
+			_unbounded.push_back(geometry);
+			continue;
+		}
+
+		_primitives.push_back(geometry);
+		boxes.push_back(bounds);
+		_bounds.expand(bounds);
+	}
+
+	if (_primitives.empty()) return;
+
+	vector<int> items(_primitives.size());
+
+	for (size_t i = 0; i < items.size(); ++i) items[i] = (int)i;
+
+	build(boxes, items, density);
+
+	if (subdivide <= 0) return;
+
+	// Crowded cells, such as those of a cluster in a large empty scene, get a grid each.
+	const int count = (int)_cells.size();
+
+	for (int c = 0; c < count; ++c) {
+		const int size = _cells[c].count;
+
+		if (size <= subdivide) continue;
+
+		const int x = c % _resolution[0], y = c / _resolution[0] % _resolution[1], z = c / _resolution[0] / _resolution[1];
+		const Vector3D lo = _bounds.getMin() + Vector3D(x * _cellSize.x(), y * _cellSize.y(), z * _cellSize.z());
+		const Vector3D hi = lo + _cellSize;
+
+		// Over the part of the cell its geometries fill, which fits a small cluster closely.
+		const vector<int> cellItems(_items.begin() + _cells[c].begin, _items.begin() + _cells[c].begin + size);
+		AABB filled;
+
+		for (int item : cellItems) filled.expand(boxes[item]);
+
+		const AABB cell(Vector3D(std::max(lo.x(), filled.getMin().x()), std::max(lo.y(), filled.getMin().y()), std::max(lo.z(), filled.getMin().z())),
+						Vector3D(std::min(hi.x(), filled.getMax().x()), std::min(hi.y(), filled.getMax().y()), std::min(hi.z(), filled.getMax().z())));
+
+		// Geometries larger than the subcells would be listed in many of them: coarser subcells, down
+		// to 2 per axis, or none.
+		std::unique_ptr<UniformGrid> grid;
+
+		for (double d = density; ; d *= 8) {
+			grid.reset(new UniformGrid(boxes, cellItems, cell, d));
+
+			if (grid->references() <= 4 * (size_t)size || grid->cells() <= 8) break;
+		}
+
+		if (grid->references() > 4 * (size_t)size || grid->cells() == 1) continue;
+
+		grid->_geometries = &_primitives;
+
+		_cells[c].count = -1 - (int)_grids.size();
+		_grids.push_back(std::move(grid));
+	}
+
+}
+
+UniformGrid::UniformGrid(const vector<AABB>& boxes, const vector<int>& items, const AABB& bounds, double density)
+	: _bounds(bounds)
+	, _geometries(nullptr) {
+	build(boxes, items, density);
+}
+
+/*------------------------------------------------------------------------------------------/
+| function:    build
+| description:
+|              List the geometries in the cells of the grid over _bounds, by counting sort.
+|
+| input:       @param boxes: bounds of all geometries.
+|              @param items: the geometries of this grid, indices into boxes.
+|              @param density: geometries per cell.
+|
+| return:      none
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+void UniformGrid::build(const vector<AABB>& boxes, const vector<int>& items, double density) {
+	resolution(_bounds, items.size(), density, _resolution);
+
+	const Vector3D extent = _bounds.getMax() - _bounds.getMin();
+	_cellSize = Vector3D(extent.x() / _resolution[0], extent.y() / _resolution[1], extent.z() / _resolution[2]);
+
+	const int count = _resolution[0] * _resolution[1] * _resolution[2];
+	_cells.assign(count, Cell{ 0, 0 });
+
+	int lo[3], hi[3];
+
+	for (int item : items) {
+		cellRange(boxes[item], lo, hi);
+
+		for (int z = lo[2]; z <= hi[2]; ++z)
+			for (int y = lo[1]; y <= hi[1]; ++y)
+				for (int x = lo[0]; x <= hi[0]; ++x)
+					++_cells[cellIndex(x, y, z)].count;
+	}
+
+	int total = 0;
+
+	for (Cell& cell : _cells) {
+		cell.begin = total;
+		total += cell.count;
+	}
+
+	_items.resize(total);
+	vector<int> next(count);
+
+	for (int c = 0; c < count; ++c) next[c] = _cells[c].begin;
+
+	for (int item : items) {
+		cellRange(boxes[item], lo, hi);
+
+		for (int z = lo[2]; z <= hi[2]; ++z)
+			for (int y = lo[1]; y <= hi[1]; ++y)
+				for (int x = lo[0]; x <= hi[0]; ++x)
+					_items[next[cellIndex(x, y, z)]++] = item;
+	}
+}
+
+void UniformGrid::resolution(const AABB& bounds, size_t count, double density, int resolution[3]) {
+	const Vector3D extent = bounds.isEmpty() ? Vector3D(0, 0, 0) : bounds.getMax() - bounds.getMin();
+	const double longest = std::max({ extent.x(), extent.y(), extent.z() });
+
+	// Flat bounds count as a thin slab, not as no volume.
+	const double thinnest = 1e-3 * longest;
+	const double volume = std::max(extent.x(), thinnest) * std::max(extent.y(), thinnest) * std::max(extent.z(), thinnest);
+	const double cells = std::max(1.0, count / std::max(density, 1e-3));
+	const double perLength = volume > 0 ? std::cbrt(cells / volume) : 0;
+
+	for (int k = 0; k < 3; ++k)
+		resolution[k] = std::max(1, std::min(maxResolution, (int)std::round(extent[k] * perLength)));
+}
+
+void UniformGrid::cellRange(const AABB& box, int lo[3], int hi[3]) const {
+	for (int k = 0; k < 3; ++k) {
+		// Padded, so a box on a cell boundary is listed in both cells and the DDA cannot step past
+		// it by rounding.
+		const double pad = 1e-7 * _cellSize[k];
+		const double a = (box.getMin()[k] - pad - _bounds.getMin()[k]) / _cellSize[k];
+		const double b = (box.getMax()[k] + pad - _bounds.getMin()[k]) / _cellSize[k];
+
+		lo[k] = _cellSize[k] > 0 ? std::max(0, std::min(_resolution[k] - 1, (int)std::floor(a))) : 0;
+		hi[k] = _cellSize[k] > 0 ? std::max(0, std::min(_resolution[k] - 1, (int)std::floor(b))) : 0;
+	}
+}
+
+size_t UniformGrid::cells() const {
+	size_t count = _cells.size();
+
+	for (auto& grid : _grids) count += grid->cells();
+
+	return count;
+}
+
+size_t UniformGrid::references() const {
+	size_t count = _items.size();
+
+	for (auto& grid : _grids) count += grid->references();
+
+	return count;
+}
+
+
+IntersectResult UniformGrid::intersect(const Ray3D& ray) const {
+	double minDist = std::numeric_limits<double>::max();
+	const Geometry* nearest = nullptr;
+
+	Profiler::countIntersectionTests((int)_unbounded.size());
+
+	for (auto& geometry : _unbounded) {
+		const double dist = geometry->calcDistance(ray);
+
+		if (dist < minDist) {
+			minDist = dist;
+			nearest = geometry.get();
+		}
+	}
+
+	if (!_primitives.empty()) traverse(ray, 0, std::numeric_limits<double>::max(), minDist, nearest);
+
+	if (!nearest) return IntersectResult::noHit;
+
+	auto&& r = nearest->calcPositionAndNormal(ray, minDist);
+	return IntersectResult(nearest, minDist, r.first, r.second);
+}
+
+/*------------------------------------------------------------------------------------------/
+| function:    traverse
+| description:
+|              Test the geometries of the cells a ray segment crosses, nearest cell first (3D-DDA).
+|
+| input:       @param ray: the ray.
+|              @param tmin, tmax: the segment.
+|              @param minDist, nearest: the nearest hit so far, updated.
+|
+| return:      none
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+void UniformGrid::traverse(const Ray3D& ray, double tmin, double tmax, double& minDist, const Geometry*& nearest) const {
+	const Vector3D& o = ray.getOrigin();
+	const Vector3D& d = ray.getDirection();
+
+	// Clip the segment to the grid.
+	for (int k = 0; k < 3; ++k) {
+		if (d[k] == 0) {
+			if (o[k] < _bounds.getMin()[k] || o[k] > _bounds.getMax()[k]) return;
+			continue;
+		}
+
+		double t0 = (_bounds.getMin()[k] - o[k]) / d[k], t1 = (_bounds.getMax()[k] - o[k]) / d[k];
+		if (t0 > t1) std::swap(t0, t1);
+
+		tmin = std::max(tmin, t0);
+		tmax = std::min(tmax, t1);
+	}
+
+	if (tmin > tmax) return;
+
+	int cell[3], step[3], end[3];
+	double next[3], delta[3];
+
+	for (int k = 0; k < 3; ++k) {
+		const double p = o[k] + d[k] * tmin;
+		cell[k] = _cellSize[k] > 0 ? std::max(0, std::min(_resolution[k] - 1, (int)std::floor((p - _bounds.getMin()[k]) / _cellSize[k]))) : 0;
+
+		if (d[k] > 0) {
+			step[k] = 1;
+			end[k] = _resolution[k];
+			next[k] = (_bounds.getMin()[k] + (cell[k] + 1) * _cellSize[k] - o[k]) / d[k];
+			delta[k] = _cellSize[k] / d[k];
+		}
+		else if (d[k] < 0) {
+			step[k] = -1;
+			end[k] = -1;
+			next[k] = (_bounds.getMin()[k] + cell[k] * _cellSize[k] - o[k]) / d[k];
+			delta[k] = -_cellSize[k] / d[k];
+		}
+		else {
+			step[k] = 0;
+			end[k] = -1;
+			next[k] = std::numeric_limits<double>::infinity();
+			delta[k] = 0;
+		}
+	}
+
+	const vector<shared_ptr<Geometry>>& geometries = *_geometries;
+	double enter = tmin;
+
+	while (true) {
+		const int axis = next[0] < next[1] ? (next[0] < next[2] ? 0 : 2) : (next[1] < next[2] ? 1 : 2);
+		const double leave = std::min(next[axis], tmax);
+		const int c = cellIndex(cell[0], cell[1], cell[2]);
+
+		const Cell& current = _cells[c];
+
+		if (current.count < 0) {
+			_grids[-1 - current.count]->traverse(ray, enter, leave, minDist, nearest);
+		}
+		else {
+			Profiler::countIntersectionTests(current.count);
+
+			for (int i = current.begin; i < current.begin + current.count; ++i) {
+				const Geometry& geometry = *geometries[_items[i]];
+				const double dist = geometry.calcDistance(ray);
+
+				if (dist < minDist) {
+					minDist = dist;
+					nearest = &geometry;
+				}
+			}
+		}
+
+		// Hits in later cells are farther than the end of this one.
+		if (minDist <= leave || next[axis] > tmax) return;
+
+		cell[axis] += step[axis];
+
+		if (cell[axis] == end[axis]) return;
+
+		enter = next[axis];
+		next[axis] += delta[axis];
+	}
+}
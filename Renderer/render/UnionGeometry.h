@@ -18,6 +18,7 @@
 #pragma once
 
 #include "Geometry.h"
+#include "Profiler.h"
 #include <vector>
 #include <limits>
 
@@ -37,6 +38,8 @@ public:
 
 	virtual pair<Vector3D, Vector3D> calcPositionAndNormal(const Ray3D& ray, double distance) const { throw Exception("Illegal function call: 'UnionGeometry' is an abstract class!"); }
 
+	virtual AABB getBounds() const;
+
 	void add(const shared_ptr<Geometry>& geometry) { _geometries.push_back(geometry); }
 
 	vector<shared_ptr<Geometry>> getAll() const { return _geometries; }
@@ -64,6 +67,8 @@ IntersectResult UnionGeometry::intersect(const Ray3D& ray) const {
 	double minDist = std::numeric_limits<double>::max();
 	int idx = -1;
 
+	Profiler::countIntersectionTests((int)_geometries.size());
+
 	for (size_t i = 0; i < _geometries.size(); ++i) {
 		double dist = _geometries[i]->calcDistance(ray);
 		if (dist < minDist) {
@@ -78,3 +83,13 @@ IntersectResult UnionGeometry::intersect(const Ray3D& ray) const {
 		return IntersectResult(_geometries[idx].get(), minDist, r.first, r.second);
 	}
 }
+
+
+AABB UnionGeometry::getBounds() const {
+	AABB bounds;
+
+	for (auto& geometry : _geometries)
+		bounds.expand(geometry->getBounds());
+
+	return bounds;
+}
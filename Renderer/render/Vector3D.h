@@ -132,6 +132,13 @@ public:
 
 	double z() const { return _z; }
 
+	// 0: x, 1: y, 2: z
+	double operator [] (int axis) const { return axis == 0 ? _x : axis == 1 ? _y : _z; }
+
+	bool operator == (const Vector3D& rhs) const { return _x == rhs._x && _y == rhs._y && _z == rhs._z; }
+
+	bool operator != (const Vector3D& rhs) const { return !(*this == rhs); }
+
 private:
 	double _x, _y, _z;
 };
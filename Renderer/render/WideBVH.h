@@ -0,0 +1,370 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     WideBVH.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Bounding volume hierarchy of 4 or 8 children per node, with the bounds of the
+//                children quantized to 8 bits.
+//
+//                It is collapsed from a FlatBVH: a node takes the two children of a binary node,
+//                then repeatedly replaces its largest internal child by that child's two children
+//                until it has Width of them.
+//
+//                A node keeps its own box as a float corner and a power of two step per axis. Each
+//                child box is given in steps from that corner, rounded outwards to bytes. A 4-wide
+//                node is one cache line and an 8-wide one two, against the 32 bytes of every binary
+//                node and leaf. Nodes near the leaves are not full, so on random sphere fields the
+//                nodes of a BVH4 take 48-50% of the memory of the FlatBVH, and those of a BVH8
+//                55-69%: a BVH8 does not reach half.
+//
+//                A ray tests all children of a node in one loop over the lanes of fixed width,
+//                which the compiler vectorizes. The children hit are ordered by distance: leaves are
+//                tested at once, nearest first, and the nodes pushed farthest first. The stack is 32
+//                entries, spilling its bottom half to memory in the rare case it fills up.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "FlatBVH.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+template<int Width>
+class WideBVH : public Geometry {
+public:
+	static_assert(Width == 4 || Width == 8, "WideBVH is 4 or 8 wide");
+
+	struct alignas(64) Node {
+		float origin[3];            // the box corner
+		int8_t exponent[3];         // the step is 2^exponent
+		uint8_t lo[3][Width];       // children bounds, in steps from origin
+		uint8_t hi[3][Width];
+		int child[Width];           // node, or the first geometry of a leaf; -1 for an empty slot
+		uint8_t count[Width];       // leaf: geometries; node: 0
+	};
+
+	WideBVH(const vector<shared_ptr<Geometry>>& geometries, FlatBVH::Method method = FlatBVH::SAH, int maxLeafSize = 4)
+		: WideBVH(FlatBVH(geometries, method, maxLeafSize)) {}
+
+	explicit WideBVH(const FlatBVH& bvh);
+
+	~WideBVH() { if (_nodes) AlignedAllocator::deallocate(_nodes, _nodeCount * sizeof(Node)); }
+
+	WideBVH(const WideBVH&) = delete;
+
+	WideBVH& operator = (const WideBVH&) = delete;
+
+	virtual IntersectResult intersect(const Ray3D& ray) const;
+
+	virtual double calcDistance(const Ray3D& ray) const { throw Exception("Illegal function call: 'WideBVH' is an abstract class!"); }
+
+	virtual pair<Vector3D, Vector3D> calcPositionAndNormal(const Ray3D& ray, double distance) const { throw Exception("Illegal function call: 'WideBVH' is an abstract class!"); }
+
+	virtual AABB getBounds() const { return _bounds; }
+
+	const Node* nodes() const { return _nodes; }
+
+	int nodeCount() const { return _nodeCount; }
+
+	size_t nodeMemory() const { return _nodeCount * sizeof(Node); }
+
+private:
+	struct Entry {
+		int node;
+		float t;
+	};
+
+	int collapse(const FlatBVH::Node* binary, int node, vector<Node>& nodes);
+
+	static float step(int8_t exponent) {
+		// 2^exponent, built from its bits.
+		const uint32_t bits = uint32_t(exponent + 127) << 23;
+		float f;
+		std::memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+
+private:
+	Node* _nodes;
+	int _nodeCount;
+
+	vector<shared_ptr<Geometry>> _primitives;
+	vector<shared_ptr<Geometry>> _unbounded;
+	AABB _bounds;
+
+	static const int stackSize = 32;
+};
+
+typedef WideBVH<4> BVH4;
+typedef WideBVH<8> BVH8;
+
+
+template<int Width>
+WideBVH<Width>::WideBVH(const FlatBVH& bvh)
+	: _nodes(nullptr)
+	, _nodeCount(0)
+	, _primitives(bvh.primitives())
+	, _unbounded(bvh.unbounded())
+	, _bounds(bvh.getBounds()) {
+	if (bvh.nodeCount() == 0) return;
+
+	vector<Node> nodes;
+	nodes.reserve(bvh.nodeCount() / (Width - 1) + 1);
+
+	collapse(bvh.nodes(), 0, nodes);
+
+	_nodeCount = (int)nodes.size();
+	_nodes = static_cast<Node*>(AlignedAllocator::allocate(nodes.size() * sizeof(Node)));
+	std::memcpy(_nodes, nodes.data(), nodes.size() * sizeof(Node));
+}
+
+/*------------------------------------------------------------------------------------------/
+| function:    collapse
+| description:
+|              Make the wide node of a binary node and, recursively, those of its descendants.
+|
+| input:       @param binary: the FlatBVH nodes.
+|              @param node: the binary node; a leaf gives a node with that leaf as its only child.
+|              @param nodes: the wide nodes, appended to.
+|
+| return:      the index of the wide node
+| note:        [10/19/2026]
+|-----------------------------------------------------------------------------------------*/
+template<int Width>
+int WideBVH<Width>::collapse(const FlatBVH::Node* binary, int node, vector<Node>& nodes) {
+	auto area = [](const FlatBVH::Node& n) {
+		const float dx = n.max[0] - n.min[0], dy = n.max[1] - n.min[1], dz = n.max[2] - n.min[2];
+		return dx * dy + dy * dz + dz * dx;
+	};
+
+	int children[Width];
+	int n = 0;
+
+	if (binary[node].isLeaf()) {
+		children[n++] = node;
+	}
+	else {
+		children[n++] = binary[node].offset;
+		children[n++] = binary[node].offset + 1;
+	}
+
+	while (n < Width) {
+		int largest = -1;
+
+		for (int k = 0; k < n; ++k)
+			if (!binary[children[k]].isLeaf() && (largest < 0 || area(binary[children[k]]) > area(binary[children[largest]]))) largest = k;
+
+		if (largest < 0) break;
+
+		const int split = children[largest];
+		children[largest] = binary[split].offset;
+		children[n++] = binary[split].offset + 1;
+	}
+
+	const int index = (int)nodes.size();
+	nodes.push_back(Node());
+
+	Node wide;
+	std::memset(&wide, 0, sizeof(wide));
+
+	const FlatBVH::Node& box = binary[node];
+	double scale[3];
+
+	for (int k = 0; k < 3; ++k) {
+		// The least step that spans the box in 255 of them.
+		const double extent = (double)box.max[k] - box.min[k];
+		int e = extent > 0 ? (int)std::ceil(std::log2(extent / 255)) : -126;
+
+		while (e < 127 && std::ldexp(255.0, e) < extent) ++e;
+		e = std::max(-126, std::min(127, e));
+
+		wide.origin[k] = box.min[k];
+		wide.exponent[k] = (int8_t)e;
+		scale[k] = std::ldexp(1.0, e);
+	}
+
+	for (int i = 0; i < Width; ++i) {
+		if (i >= n) {
+			// Inverted, and marked empty.
+			for (int k = 0; k < 3; ++k) {
+				wide.lo[k][i] = 255;
+				wide.hi[k][i] = 0;
+			}
+
+			wide.child[i] = -1;
+			continue;
+		}
+
+		const FlatBVH::Node& c = binary[children[i]];
+
+		for (int k = 0; k < 3; ++k) {
+			const double lo = std::floor((c.min[k] - (double)wide.origin[k]) / scale[k]);
+			const double hi = std::ceil((c.max[k] - (double)wide.origin[k]) / scale[k]);
+
+			wide.lo[k][i] = (uint8_t)std::max(0.0, std::min(255.0, lo));
+			wide.hi[k][i] = (uint8_t)std::max(0.0, std::min(255.0, hi));
+		}
+
+		if (c.isLeaf()) {
+			if (c.count > 255) throw Exception("WideBVH: leaves hold 255 geometries at most!");
+
+			wide.child[i] = c.offset;
+			wide.count[i] = (uint8_t)c.count;
+		}
+		else {
+			wide.child[i] = collapse(binary, children[i], nodes);
+		}
+	}
+
+	nodes[index] = wide;
+
+	return index;
+}
+
+
+template<int Width>
+IntersectResult WideBVH<Width>::intersect(const Ray3D& ray) const {
+	double minDist = std::numeric_limits<double>::max();
+	const Geometry* nearest = nullptr;
+
+	Profiler::countIntersectionTests((int)_unbounded.size());
+
+	for (auto& geometry : _unbounded) {
+		const double dist = geometry->calcDistance(ray);
+
+		if (dist < minDist) {
+			minDist = dist;
+			nearest = geometry.get();
+		}
+	}
+
+	if (_nodeCount > 0) {
+		float o[3], inverse[3];
+		bool negative[3];
+
+		for (int k = 0; k < 3; ++k) {
+			const double d = ray.getDirection()[k];
+
+			o[k] = (float)ray.getOrigin()[k];
+			inverse[k] = d != 0 ? (float)(1 / d) : std::copysign(1e30f, (float)d);
+			negative[k] = inverse[k] < 0;
+		}
+
+		Entry stack[stackSize];
+		int size = 0;
+
+		static thread_local vector<Entry> spill;
+		spill.clear();
+
+		stack[size++] = Entry{ 0, 0.f };
+
+		while (true) {
+			if (size == 0) {
+				if (spill.empty()) break;
+
+				while (size < stackSize / 2 && !spill.empty()) {
+					stack[size++] = spill.back();
+					spill.pop_back();
+				}
+
+				std::reverse(stack, stack + size);
+			}
+
+			const Entry entry = stack[--size];
+
+			if (entry.t >= minDist) continue;
+
+			const Node& node = _nodes[entry.node];
+
+			// Lane i enters at near[i] and leaves at far[i]; the planes of each axis are origin +
+			// q * step, so the distances are a + q * b.
+			float a[3], b[3];
+			const uint8_t* nearPlane[3];
+			const uint8_t* farPlane[3];
+
+			for (int k = 0; k < 3; ++k) {
+				a[k] = (node.origin[k] - o[k]) * inverse[k];
+				b[k] = step(node.exponent[k]) * inverse[k];
+				nearPlane[k] = negative[k] ? node.hi[k] : node.lo[k];
+				farPlane[k] = negative[k] ? node.lo[k] : node.hi[k];
+			}
+
+			const float tmax = (float)minDist;
+			float tnear[Width], tfar[Width];
+
+			for (int i = 0; i < Width; ++i) {
+				const float x0 = a[0] + nearPlane[0][i] * b[0], x1 = a[0] + farPlane[0][i] * b[0];
+				const float y0 = a[1] + nearPlane[1][i] * b[1], y1 = a[1] + farPlane[1][i] * b[1];
+				const float z0 = a[2] + nearPlane[2][i] * b[2], z1 = a[2] + farPlane[2][i] * b[2];
+
+				tnear[i] = std::max(std::max(x0, y0), std::max(z0, 0.f));
+				// float rounding must not lose a grazing hit
+				tfar[i] = std::min(std::min(x1, y1), z1) * 1.000001f;
+				tfar[i] = std::min(tfar[i], tmax);
+			}
+
+			// Children hit, nearest first.
+			int hits[Width];
+			int hitCount = 0;
+
+			for (int i = 0; i < Width; ++i) {
+				if (node.child[i] < 0 || tnear[i] > tfar[i]) continue;
+
+				int k = hitCount++;
+
+				for (; k > 0 && tnear[hits[k - 1]] > tnear[i]; --k)
+					hits[k] = hits[k - 1];
+
+				hits[k] = i;
+			}
+
+			for (int k = 0; k < hitCount; ++k) {
+				const int i = hits[k];
+
+				if (node.count[i] == 0 || tnear[i] >= minDist) continue;
+
+				Profiler::countIntersectionTests(node.count[i]);
+
+				for (int p = node.child[i]; p < node.child[i] + node.count[i]; ++p) {
+					const double dist = _primitives[p]->calcDistance(ray);
+
+					if (dist < minDist) {
+						minDist = dist;
+						nearest = _primitives[p].get();
+					}
+				}
+			}
+
+			for (int k = hitCount - 1; k >= 0; --k) {
+				const int i = hits[k];
+
+				if (node.count[i] != 0 || tnear[i] >= minDist) continue;
+
+				if (size == stackSize) {
+					// The bottom half, farthest of all, waits in memory.
+					spill.insert(spill.end(), stack, stack + stackSize / 2);
+					std::memmove(stack, stack + stackSize / 2, (stackSize / 2) * sizeof(Entry));
+					size -= stackSize / 2;
+				}
+
+				stack[size++] = Entry{ node.child[i], tnear[i] };
+			}
+		}
+	}
+
+	if (!nearest) return IntersectResult::noHit;
+
+	auto&& r = nearest->calcPositionAndNormal(ray, minDist);
+	return IntersectResult(nearest, minDist, r.first, r.second);
+}
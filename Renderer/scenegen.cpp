@@ -0,0 +1,170 @@
+#include <iostream>
+#include <cstring>
+#include <chrono>
+
+#include "SceneGenerator.h"
+#include "Regression.h"
+#include "WideBVH.h"
+#include "Accelerator.h"
+
+static void usage(const char* name) {
+	cerr << "usage: " << name << " field|flake|grid|lights|glass|load [options]\n"
+		"  --count n              spheres of field, lights of lights, layers of glass (default 1000)\n"
+		"  --depth n              levels of flake (default 3)\n"
+		"  --grid XxYxZ           cells of grid (default 10x10x1)\n"
+		"  --cluster n            spheres per cell of grid (default 16)\n"
+		"  --distribution uniform|clustered|ground    of field\n"
+		"  --mix d,s,r,e          weights of diffuse, specular, refractive and emissive spheres\n"
+		"  --method path|ray|light\n"
+		"  --accelerate none|sah|lbvh|bvh4|bvh8|grid|auto    traces through a FlatBVH, one collapsed\n"
+		"                         to 4 or 8 wide, a UniformGrid, or what Accelerator chooses (default none)\n"
+		"  --seed n\n"
+		"  --in file              scene file to load\n"
+		"  --out file             writes the scene file\n"
+		"  --render file          renders the scene to a PPM image\n"
+		"  --size WxH             of the image (default 320x240)\n"
+		"  --samples n            per pixel / 4, when path tracing (default 4)" << endl;
+}
+
+// scenegen.exe <generator> [options]: generates a stress scene, writes it and / or renders it.
+int main(int argc, char *argv[]){
+	if (argc < 2) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	const string generator = argv[1];
+	string in, out, image;
+	int count = 1000, depth = 3, nx = 10, ny = 10, nz = 1, cluster = 16, samples = 4, w = 320, h = 240;
+	uint32_t seed = 1;
+	SceneGenerator::Distribution distribution = SceneGenerator::UNIFORM;
+	SceneGenerator::MaterialMix mix;
+	Scene::Method method = generator == "lights" ? Scene::RENDER_LIGHT : Scene::PATH_TRACE;
+	string accelerate = "none";
+
+	for (int i = 2; i < argc; ++i) {
+		const bool value = i + 1 < argc;
+		const char* next = value ? argv[i + 1] : "";
+		bool ok = value;
+
+		if (!strcmp(argv[i], "--count")) count = atoi(next);
+		else if (!strcmp(argv[i], "--depth")) depth = atoi(next);
+		else if (!strcmp(argv[i], "--grid")) ok = sscanf(next, "%dx%dx%d", &nx, &ny, &nz) == 3;
+		else if (!strcmp(argv[i], "--cluster")) cluster = atoi(next);
+		else if (!strcmp(argv[i], "--mix")) ok = sscanf(next, "%lf,%lf,%lf,%lf", &mix.diffuse, &mix.specular, &mix.refractive, &mix.emissive) >= 3;
+		else if (!strcmp(argv[i], "--seed")) seed = (uint32_t)strtoul(next, nullptr, 10);
+		else if (!strcmp(argv[i], "--in")) in = next;
+		else if (!strcmp(argv[i], "--out")) out = next;
+		else if (!strcmp(argv[i], "--render")) image = next;
+		else if (!strcmp(argv[i], "--size")) ok = sscanf(next, "%dx%d", &w, &h) == 2;
+		else if (!strcmp(argv[i], "--samples")) samples = atoi(next);
+		else if (!strcmp(argv[i], "--distribution")) {
+			if (!strcmp(next, "uniform")) distribution = SceneGenerator::UNIFORM;
+			else if (!strcmp(next, "clustered")) distribution = SceneGenerator::CLUSTERED;
+			else if (!strcmp(next, "ground")) distribution = SceneGenerator::GROUND;
+			else ok = false;
+		}
+		else if (!strcmp(argv[i], "--method")) {
+			if (!strcmp(next, "path")) method = Scene::PATH_TRACE;
+			else if (!strcmp(next, "ray")) method = Scene::RAY_TRACE;
+			else if (!strcmp(next, "light")) method = Scene::RENDER_LIGHT;
+			else ok = false;
+		}
+		else if (!strcmp(argv[i], "--accelerate")) {
+			accelerate = next;
+			ok = accelerate == "none" || accelerate == "sah" || accelerate == "lbvh" || accelerate == "bvh4" || accelerate == "bvh8"
+				|| accelerate == "grid" || accelerate == "auto";
+		}
+		else ok = false;
+
+		if (!ok) {
+			usage(argv[0]);
+			return 2;
+		}
+
+		++i;
+	}
+
+	try {
+		auto start = std::chrono::steady_clock::now();
+		auto elapsed = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+
+		SceneDescription description;
+
+		if (generator == "field") description = SceneGenerator::sphereField(count, distribution, mix, method, seed);
+		else if (generator == "flake") description = SceneGenerator::sphereFlake(depth, mix, method, seed);
+		else if (generator == "grid") description = SceneGenerator::instanceGrid(nx, ny, nz, cluster, mix, method, seed);
+		else if (generator == "lights") description = SceneGenerator::lightArray(count, method, seed);
+		else if (generator == "glass") description = SceneGenerator::glassStack(count, method, seed);
+		else if (generator == "load" && !in.empty()) description = SceneDescription::load(in);
+		else {
+			usage(argv[0]);
+			return 2;
+		}
+
+		printf("%s: %llu primitives, %llu lights, %llu materials in %.2f sec\n", description.name.c_str(),
+			(unsigned long long)description.primitives(), (unsigned long long)description.lights.size(),
+			(unsigned long long)description.materials.size(), elapsed());
+
+		if (!out.empty()) {
+			start = std::chrono::steady_clock::now();
+			description.save(out);
+			printf("saved %s in %.2f sec\n", out.c_str(), elapsed());
+		}
+
+		if (!image.empty()) {
+			start = std::chrono::steady_clock::now();
+			const Scene scene = description.build();
+			printf("built in %.2f sec, peak memory %.1f MB\n", elapsed(), Regression::peakMemory() / 1048576.0);
+
+			unique_ptr<Geometry> bvh;
+
+			if (accelerate == "auto") {
+				start = std::chrono::steady_clock::now();
+				const Accelerator::Statistics statistics = Accelerator::statistics(scene.geometry.getAll());
+				const Accelerator::Type type = Accelerator::choose(scene.geometry.getAll());
+
+				accelerate = type == Accelerator::GRID ? "grid" : type == Accelerator::FLAT_BVH ? "sah" : "none";
+				printf("%.2f references per geometry, %.2f of cells occupied: %s, in %.2f sec\n", statistics.references, statistics.occupancy, accelerate.c_str(), elapsed());
+			}
+
+			if (accelerate == "grid") {
+				start = std::chrono::steady_clock::now();
+				UniformGrid* grid = new UniformGrid(scene.geometry.getAll());
+				bvh.reset(grid);
+
+				printf("grid of %dx%dx%d, %llu cells and %llu references in %.2f sec\n", grid->resolution(0), grid->resolution(1), grid->resolution(2),
+					(unsigned long long)grid->cells(), (unsigned long long)grid->references(), elapsed());
+			}
+			else if (accelerate != "none") {
+				start = std::chrono::steady_clock::now();
+				FlatBVH* flat = new FlatBVH(scene.geometry.getAll(), accelerate == "lbvh" ? FlatBVH::LBVH : FlatBVH::SAH);
+				size_t memory = flat->nodeMemory();
+				bvh.reset(flat);
+
+				if (accelerate == "bvh4") {
+					BVH4* wide = new BVH4(*flat);
+					memory = wide->nodeMemory();
+					bvh.reset(wide);
+				}
+				else if (accelerate == "bvh8") {
+					BVH8* wide = new BVH8(*flat);
+					memory = wide->nodeMemory();
+					bvh.reset(wide);
+				}
+
+				printf("%s BVH of %.1f MB in %.2f sec\n", accelerate.c_str(), memory / 1048576.0, elapsed());
+			}
+
+			start = std::chrono::steady_clock::now();
+			PXMImage::save(renderScene(scene, Size(h, w, 3), samples, bvh.get()), image);
+			printf("rendered %s in %.2f sec, peak memory %.1f MB\n", image.c_str(), elapsed(), Regression::peakMemory() / 1048576.0);
+		}
+	}
+	catch (exception& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,402 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     Benchmark.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Microbenchmarks of the intersection, acceleration structure, camera, path tracing,
+//                image filter and image file kernels, run by bench.cpp.
+//
+//                Every case is warmed up, then timed in several repetitions of enough iterations to
+//                last minSeconds each. The median over repetitions gives the rate, in millions of
+//                rays, samples, pixels or bytes per second; the best one is reported as well. Results
+//                print as a table, or as JSON for scripts. The image filters are timed on all
+//                threads and on a single one.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Matrix.h"
+#include "IP.h"
+#include "PXMImage.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "UnionGeometry.h"
+#include "PerspectiveCamera .h"
+#include "Render.h"
+#include "RandomPCG.h"
+#include "Scenes.h"
+#include "FlatBVH.h"
+#include "WideBVH.h"
+#include "UniformGrid.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+class Benchmark {
+public:
+
+	struct Result {
+		std::string name;
+		std::string unit;       // of rate
+		double items;           // per iteration
+		double rate;            // millions of items per second, from the median
+		double medianSeconds;   // per iteration
+		double bestSeconds;     // per iteration
+		int iterations;         // per repetition
+		int repetitions;
+	};
+
+	// Only cases whose name contains 'filter' run. 'quick' takes fewer and shorter repetitions, and skips 4K images.
+	explicit Benchmark(const std::string& filter = "", bool quick = false)
+		: _filter(filter)
+		, _quick(quick)
+		, _repetitions(quick ? 3 : 7)
+		, _minSeconds(quick ? 0.02 : 0.1)
+	{}
+
+	// Times f, which processes 'items' items of 'unit' (e.g. "Mrays/s") per call.
+	void run(const std::string& name, const std::string& unit, double items, const std::function<void()>& f);
+
+	bool quick() const { return _quick; }
+
+	const std::vector<Result>& results() const { return _results; }
+
+	std::string json() const;
+
+	// One line per case, as it finishes.
+	bool verbose = true;
+
+private:
+	static double seconds(const std::function<void()>& f, int iterations) {
+		const auto start = std::chrono::steady_clock::now();
+
+		for (int n = 0; n < iterations; ++n)
+			f();
+
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		return elapsed.count();
+	}
+
+	std::string _filter;
+	bool _quick;
+	int _repetitions;
+	double _minSeconds;
+	std::vector<Result> _results;
+};
+
+
+void Benchmark::run(const std::string& name, const std::string& unit, double items, const std::function<void()>& f) {
+	if (name.find(_filter) == std::string::npos) return;
+
+	// Warm up, and size the repetitions.
+	const double once = std::max(seconds(f, 1), 1e-9);
+	const int iterations = std::max(1, (int)std::min(_minSeconds / once, 1e6));
+
+	std::vector<double> times;
+
+	for (int r = 0; r < _repetitions; ++r)
+		times.push_back(seconds(f, iterations) / iterations);
+
+	std::sort(times.begin(), times.end());
+
+	Result result;
+	result.name = name;
+	result.unit = unit;
+	result.items = items;
+	result.medianSeconds = times[times.size() / 2];
+	result.bestSeconds = times.front();
+	result.rate = items / result.medianSeconds * 1e-6;
+	result.iterations = iterations;
+	result.repetitions = _repetitions;
+
+	_results.push_back(result);
+
+	if (verbose) {
+		printf("%-44s %12.3f %-10s %12.3f ms  (best %.3f ms)\n", name.c_str(), result.rate, unit.c_str(),
+			result.medianSeconds * 1e3, result.bestSeconds * 1e3);
+		fflush(stdout);
+	}
+}
+
+std::string Benchmark::json() const {
+#ifdef _OPENMP
+	const int threads = omp_get_max_threads();
+#else
+	const int threads = 1;
+#endif
+
+	std::string s = String::format("{\n  \"threads\": %d,\n  \"results\": [\n", threads);
+
+	for (size_t i = 0; i < _results.size(); ++i) {
+		const Result& r = _results[i];
+
+		s += String::format("    {\"name\": \"%s\", \"unit\": \"%s\", \"rate\": %.6g, \"medianSeconds\": %.6g, \"bestSeconds\": %.6g, "
+			"\"items\": %.0f, \"iterations\": %d, \"repetitions\": %d}%s\n",
+			r.name.c_str(), r.unit.c_str(), r.rate, r.medianSeconds, r.bestSeconds, r.items, r.iterations, r.repetitions,
+			i + 1 < _results.size() ? "," : "");
+	}
+
+	s += "  ]\n}\n";
+
+	return s;
+}
+
+
+// Unit rays from the origin region towards random directions, so about half of them hit.
+std::vector<Ray3D> benchmarkRays(int n) {
+	std::mt19937 mt(1);
+	std::uniform_real_distribution<double> dist(-1, 1);
+	std::vector<Ray3D> rays;
+
+	for (int i = 0; i < n; ++i)
+		rays.push_back(Ray3D(Vector3D(dist(mt), dist(mt), dist(mt)), Vector3D(dist(mt), dist(mt), dist(mt) + 2).norm()));
+
+	return rays;
+}
+
+void benchmarkGeometry(Benchmark& bench) {
+	const int n = 1 << 14;
+	const std::vector<Ray3D> rays = benchmarkRays(n);
+	volatile double sink = 0;
+
+	const Sphere sphere(Vector3D(0, 0, 10), 5);
+	const Plane plane(Vector3D(0, 0, -1), -10);
+
+	bench.run("Sphere::calcDistance", "Mrays/s", n, [&]() {
+		double s = 0;
+		for (const Ray3D& ray : rays) s += sphere.calcDistance(ray) < 1e300;
+		sink = sink + s;
+	});
+
+	bench.run("Plane::calcDistance", "Mrays/s", n, [&]() {
+		double s = 0;
+		for (const Ray3D& ray : rays) s += plane.calcDistance(ray) < 1e300;
+		sink = sink + s;
+	});
+
+	bench.run("Sphere::intersect", "Mrays/s", n, [&]() {
+		double s = 0;
+		for (const Ray3D& ray : rays) s += sphere.intersect(ray).getDistance();
+		sink = sink + s;
+	});
+
+	// Spheres scattered in front of the rays.
+	for (int count = 1; count <= 256; count *= 4) {
+		std::mt19937 mt(2);
+		std::uniform_real_distribution<double> dist(-20, 20);
+		vector<shared_ptr<Geometry>> spheres;
+
+		for (int i = 0; i < count; ++i)
+			spheres.push_back(make_shared<Sphere>(Vector3D(dist(mt), dist(mt), 30 + dist(mt)), 2));
+
+		const UnionGeometry scene(spheres);
+
+		bench.run(String::format("UnionGeometry::intersect N=%d", count), "Mrays/s", n, [&]() {
+			double s = 0;
+			for (const Ray3D& ray : rays) s += scene.intersect(ray).getDistance();
+			sink = sink + s;
+		});
+	}
+}
+
+// FlatBVH and UniformGrid builds of random spheres, and rays through them and through the BVH4
+// and BVH8 of the FlatBVH; quick runs skip a million spheres.
+void benchmarkAcceleration(Benchmark& bench) {
+	const int n = 1 << 14;
+	const std::vector<Ray3D> rays = benchmarkRays(n);
+	volatile double sink = 0;
+
+	for (int count = 100000; count <= 1000000; count *= 10) {
+		if (bench.quick() && count > 100000) break;
+
+		// As dense as the spheres of benchmarkGeometry, in a volume growing with their number.
+		std::mt19937 mt(3);
+		std::uniform_real_distribution<double> dist(-1, 1);
+		const double half = 20 * std::cbrt(count / 256.0);
+		vector<shared_ptr<Geometry>> spheres;
+
+		for (int i = 0; i < count; ++i)
+			spheres.push_back(make_shared<Sphere>(Vector3D(half * dist(mt), half * dist(mt), 30 + half + half * dist(mt)), 2));
+
+		const std::pair<FlatBVH::Method, const char*> methods[] = { { FlatBVH::SAH, "SAH" }, { FlatBVH::LBVH, "LBVH" } };
+
+		for (auto& method : methods) {
+			bench.run(String::format("FlatBVH build %s N=%d", method.second, count), "Mprims/s", count, [&]() {
+				FlatBVH bvh(spheres, method.first);
+				sink = sink + bvh.nodeCount();
+			});
+
+			const FlatBVH bvh(spheres, method.first);
+
+			bench.run(String::format("FlatBVH::intersect %s N=%d", method.second, count), "Mrays/s", n, [&]() {
+				double s = 0;
+				for (const Ray3D& ray : rays) s += bvh.intersect(ray).getDistance();
+				sink = sink + s;
+			});
+		}
+
+		bench.run(String::format("UniformGrid build N=%d", count), "Mprims/s", count, [&]() {
+			UniformGrid grid(spheres);
+			sink = sink + grid.cells();
+		});
+
+		const UniformGrid grid(spheres);
+
+		bench.run(String::format("UniformGrid::intersect N=%d", count), "Mrays/s", n, [&]() {
+			double s = 0;
+			for (const Ray3D& ray : rays) s += grid.intersect(ray).getDistance();
+			sink = sink + s;
+		});
+
+		const FlatBVH bvh(spheres);
+		const BVH4 bvh4(bvh);
+		const BVH8 bvh8(bvh);
+
+		bench.run(String::format("BVH4::intersect N=%d", count), "Mrays/s", n, [&]() {
+			double s = 0;
+			for (const Ray3D& ray : rays) s += bvh4.intersect(ray).getDistance();
+			sink = sink + s;
+		});
+
+		bench.run(String::format("BVH8::intersect N=%d", count), "Mrays/s", n, [&]() {
+			double s = 0;
+			for (const Ray3D& ray : rays) s += bvh8.intersect(ray).getDistance();
+			sink = sink + s;
+		});
+	}
+}
+
+void benchmarkRender(Benchmark& bench) {
+	const Size size(240, 320, 3);
+	const PerspectiveCamera camera = globalIlluminationCamera(size);
+	const UnionGeometry scene = globalIlluminationScene();
+	volatile double sink = 0;
+
+	bench.run("PerspectiveCamera::generateRay", "Mrays/s", size.height() * size.width(), [&]() {
+		double s = 0;
+
+		for (int i = 0; i < size.height(); ++i)
+			for (int j = 0; j < size.width(); ++j)
+				s += camera.generateRay((j + 0.5) / size.width(), (i + 0.5) / size.height()).getDirection().x();
+
+		sink = sink + s;
+	});
+
+	// One sample per pixel of a coarse grid, on one thread.
+	const int step = 8;
+	const double samples = (size.height() / step) * (size.width() / step);
+
+	bench.run("Render::pathTraceRecursive", "Msamples/s", samples, [&]() {
+		double s = 0;
+
+		for (int i = 0; i < size.height(); i += step) {
+			for (int j = 0; j < size.width(); j += step) {
+				RandomPCG rand(i * size.width() + j, 0);
+				const Ray3D ray = camera.generateRay((j + 0.5) / size.width(), (i + 0.5) / size.height());
+
+				s += Render::pathTraceRecursive(scene, ray, 0, rand).r;
+			}
+		}
+
+		sink = sink + s;
+	});
+}
+
+void benchmarkImage(Benchmark& bench) {
+#ifdef _OPENMP
+	const int threads = omp_get_max_threads();
+#endif
+
+	std::vector<Size> sizes = { Size(256, 256, 3), Size(1024, 1024, 3) };
+
+	if (!bench.quick()) sizes.push_back(Size(2160, 3840, 3));
+
+	for (const Size& size : sizes) {
+		const int height = size.height(), width = size.width();
+		const double pixels = (double)height * width;
+
+		Matrix<float> imInput(height, width, 3), imOutput;
+		Matrix<double> integral;
+		std::mt19937 mt(0);
+		std::uniform_real_distribution<float> dist(0, 1);
+
+		for (int i = 0; i < imInput.length(); ++i)
+			imInput.data()[i] = dist(mt);
+
+		// Flat geometry, so the edge stopping functions weigh by colour and albedo alone.
+		Matrix<float> normal(height, width, 3), depth(height, width, 1);
+		Matrix<int> id(height, width, 1);
+
+		const std::string suffix = String::format(" %dx%d", width, height);
+
+		// On all threads, then again on a single one for the parallel speedup.
+		auto filter = [&](const std::string& name, const std::function<void()>& f) {
+			bench.run(name + suffix, "MPix/s", pixels, f);
+
+#ifdef _OPENMP
+			if (threads > 1) {
+				omp_set_num_threads(1);
+				bench.run(name + suffix + " 1 thread", "MPix/s", pixels, f);
+				omp_set_num_threads(threads);
+			}
+#endif
+		};
+
+		filter("IP::gaussianBlurRecursive", [&]() { IP::gaussianBlurRecursive(imInput, imOutput, 5.0); });
+		filter("IP::gaussianBlurLinearTime", [&]() { IP::gaussianBlurLinearTime(imInput, imOutput, 5, 2.0); });
+		filter("IP::meanBlurLinearTime", [&]() { IP::meanBlurLinearTime(imInput, imOutput, 5); });
+		filter("IP::meanBlurConstantTime", [&]() { IP::meanBlurConstantTime(imInput, imOutput, 5); });
+		filter("IP::calcIntegralImage", [&]() { IP::calcIntegralImage(imInput, integral); });
+		filter("IP::bilateralBlurPorikli", [&]() { IP::bilateralBlurPorikli(imInput, imOutput, 5, 2.0, 0.2); });
+		filter("IP::bilateralBlurYang", [&]() { IP::bilateralBlurYang(imInput, imOutput, 5, 2.0, 0.2); });
+
+		// Tens of seconds a call at 4K.
+		if (height <= 1024) {
+			filter("IP::denoiseATrous", [&]() {
+				IP::denoiseATrous(imInput, imOutput, imInput, normal, depth, id);
+			});
+		}
+	}
+}
+
+void benchmarkFiles(Benchmark& bench, const std::string& filepath) {
+	const int height = 1024, width = 1024;
+	Matrix<uint8> image(height, width, 3), loaded;
+
+	for (int i = 0; i < image.length(); ++i)
+		image.data()[i] = (uint8)(i * 2654435761u >> 24);
+
+	const double bytes = (double)image.length();
+
+	bench.run("PXMImage::save 1024x1024", "MB/s", bytes, [&]() { PXMImage::save(image, filepath); });
+	bench.run("PXMImage::open 1024x1024", "MB/s", bytes, [&]() { loaded = PXMImage::open(filepath); });
+	bench.run("PXMImage::openRegion 64x64", "MB/s", 64 * 64 * 3, [&]() { loaded = PXMImage::openRegion(filepath, 480, 480, 64, 64); });
+
+	std::remove(filepath.c_str());
+}
+
+void benchmarkAll(Benchmark& bench, const std::string& scratchFile = "bench.ppm") {
+	benchmarkGeometry(bench);
+	benchmarkAcceleration(bench);
+	benchmarkRender(bench);
+	benchmarkImage(bench);
+	benchmarkFiles(bench, scratchFile);
+}
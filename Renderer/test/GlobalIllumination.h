@@ -14,31 +14,12 @@
 #include "PointLight.h"
 #include "SpotLight.h"
 #include "LambertMaterial.h"
+#include "Scenes.h"
+#include "AnimationRenderer.h"
 
 void smallpt() {
 
-	// Two spheres
-	auto sphere1 = make_shared<Sphere>(Vector3D(1e5+1,40.8,81.6),   1e5);   //Left
-	auto sphere2 = make_shared<Sphere>(Vector3D(-1e5+99,40.8,81.6), 1e5);	//Rght
-	auto sphere3 = make_shared<Sphere>(Vector3D(50, 40.8, 1e5),     1e5);   //Back
-	auto sphere4 = make_shared<Sphere>(Vector3D(50,40.8,-1e5+170),  1e5);  	//Frnt
-	auto sphere5 = make_shared<Sphere>(Vector3D(50, 1e5, 81.6),     1e5);	//Botm
-	auto sphere6 = make_shared<Sphere>(Vector3D(50,-1e5+81.6,81.6), 1e5);	//Top
-	auto sphere7 = make_shared<Sphere>(Vector3D(27,16.5,47),        16.5);	//Mirr
-	auto sphere8 = make_shared<Sphere>(Vector3D(73,16.5,78),        16.5);	//Glas
-	auto sphere9 = make_shared<Sphere>(Vector3D(50,681.6-.27,81.6), 600);	//Lite
-
-	sphere1->setMaterial(make_shared<IdealMaterial>(Color(.75, .25, .25), Color::BLACK, IdealType::DIFFUSE));    //Left
-	sphere2->setMaterial(make_shared<IdealMaterial>(Color(.25, .25, .75), Color::BLACK, IdealType::DIFFUSE));    //Rght
-	sphere3->setMaterial(make_shared<IdealMaterial>(Color(.75, .75, .75), Color::BLACK, IdealType::DIFFUSE));    //Back
-	sphere4->setMaterial(make_shared<IdealMaterial>(Color::BLACK,         Color::BLACK, IdealType::DIFFUSE));    //Frnt
-	sphere5->setMaterial(make_shared<IdealMaterial>(Color(.75, .75, .75), Color::BLACK, IdealType::DIFFUSE));    //Botm
-	sphere6->setMaterial(make_shared<IdealMaterial>(Color(.75, .75, .75), Color::BLACK, IdealType::DIFFUSE));    //Top
-	sphere7->setMaterial(make_shared<IdealMaterial>(Color::WHITE*.999,    Color::BLACK, IdealType::SPECULAR));   //Mirr
-	sphere8->setMaterial(make_shared<IdealMaterial>(Color::WHITE*.999,    Color::BLACK, IdealType::REFRACTIVE)); //Glas
-	sphere9->setMaterial(make_shared<IdealMaterial>(Color::BLACK,         Color::WHITE*12, IdealType::DIFFUSE)); //Lite
-
-	UnionGeometry geometries({ sphere1, sphere2, sphere3, sphere4, sphere5, sphere6, sphere7, sphere8, sphere9});
+	const UnionGeometry geometries = smallptScene();
 
 
 	auto clamp = [](double x)->double {
@@ -108,103 +89,71 @@ void smallpt() {
 	delete[] c;
 }
 
-Matrix<uint8> globalIlluminationTest(const Size& size, int samples) {
-	auto plane1 = make_shared<Plane>(Vector3D(0, 0, 1),    0);    // ground
-	auto plane2 = make_shared<Plane>(Vector3D(1, 0, 0),  -100);  // back
-	auto plane3 = make_shared<Plane>(Vector3D(0, 1, 0),  -60);  // left
-	auto plane4 = make_shared<Plane>(Vector3D(0, -1, 0), -60); // right
-	auto plane5 = make_shared<Plane>(Vector3D(0, 0, -1), -100); // ceil
-	auto plane6 = make_shared<Plane>(Vector3D(-1, 0, 0), -20);   // front
-
-	plane1->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.75, 0.75), Color::BLACK, IdealType::DIFFUSE));
-	plane2->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.75, 0.75), Color::BLACK, IdealType::DIFFUSE));
-	plane3->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.25, 0.25), Color::BLACK, IdealType::DIFFUSE));
-	plane4->setMaterial(make_shared<IdealMaterial>(Color(0.25, 0.25, 0.75), Color::BLACK, IdealType::DIFFUSE));
-	plane5->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.75, 0.75), Color::BLACK, IdealType::DIFFUSE));
-	plane6->setMaterial(make_shared<IdealMaterial>(Color(0.50, 0.84, 0.81), Color::BLACK, IdealType::DIFFUSE));
-
-	auto sphere1 = make_shared<Sphere>(Vector3D(-60, -27.5, 20), 20);
-	auto sphere2 = make_shared<Sphere>(Vector3D(-45, 30, 20), 20);
-	auto sphere3 = make_shared<Sphere>(Vector3D(-50, 0, 100 + 97), 100); // light
-
-	sphere1->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::SPECULAR));
-	sphere2->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
-	sphere3->setMaterial(make_shared<IdealMaterial>(Color(.75, .75, .75), Color(7.5, 7.5, 7.5), IdealType::DIFFUSE));
-
-	UnionGeometry geometries({ plane1, plane2, plane3, plane4, plane5, plane6, sphere1, sphere2, sphere3 });
+Matrix<uint8> globalIlluminationTest(const Size& size, int samples, AOV* aov = nullptr) {
+	UnionGeometry geometries = globalIlluminationScene();
 
 	clock_t start = clock();
 
-	Matrix<uint8> mat = Render::pathTrace(geometries,
-										  PerspectiveCamera(Vector3D(150, 0, 50), Vector3D(-1, 0, 0), Vector3D(0, 0, 1), 37, (1.0 * size.width()) / size.height()),
-										  samples,
-										  size);
+	Matrix<uint8> mat = Render::pathTrace(geometries, globalIlluminationCamera(size), samples, size, aov);
 
 	printf("\n%f sec\n", (float)(clock() - start) / CLOCKS_PER_SEC);
 
 	return mat;
 }
 
-void globalIlluminationAnimation() {
-	auto plane1 = make_shared<Plane>(Vector3D(0, 0, 1), 0);    // ground
-	auto plane2 = make_shared<Plane>(Vector3D(1, 0, 0), -100);  // back
-	auto plane3 = make_shared<Plane>(Vector3D(0, 1, 0), -60);  // left
-	auto plane4 = make_shared<Plane>(Vector3D(0, -1, 0), -60); // right
-	auto plane5 = make_shared<Plane>(Vector3D(0, 0, -1), -100); // ceil
-	auto plane6 = make_shared<Plane>(Vector3D(-1, 0, 0), 0);   // front
+// The same scene reconstructed with a filter, e.g. make_shared<MitchellFilter>().
+Matrix<uint8> globalIlluminationFilmTest(const Size& size, int samples, const shared_ptr<Filter>& filter) {
+	UnionGeometry geometries = globalIlluminationScene();
+	Film film(size.height(), size.width(), filter);
 
-	plane1->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.75, 0.75), Color::BLACK, IdealType::DIFFUSE));
-	plane2->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.75, 0.75), Color::BLACK, IdealType::DIFFUSE));
-	plane3->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.25, 0.25), Color::BLACK, IdealType::DIFFUSE));
-	plane4->setMaterial(make_shared<IdealMaterial>(Color(0.25, 0.25, 0.75), Color::BLACK, IdealType::DIFFUSE));
-	plane5->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.75, 0.75), Color::BLACK, IdealType::DIFFUSE));
-	plane6->setMaterial(make_shared<IdealMaterial>(Color(0.50, 0.84, 0.81), Color::BLACK, IdealType::DIFFUSE));
+	clock_t start = clock();
 
-	auto sphere1 = make_shared<Sphere>(Vector3D(-70, -30, 20), 20);
-	auto sphere3 = make_shared<Sphere>(Vector3D(-50, 0, 100 + 97), 100); // light
+	Render::pathTrace(geometries, globalIlluminationCamera(size), samples, film);
 
-	sphere1->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::SPECULAR));
-	sphere3->setMaterial(make_shared<IdealMaterial>(Color(.75, .75, .75), Color(7.5, 7.5, 7.5), IdealType::DIFFUSE));
+	printf("\n%f sec\n", (float)(clock() - start) / CLOCKS_PER_SEC);
 
-	int frame = 3;
+	return film.image();
+}
 
-	for (int i = 0; i < frame; ++i) {
-		double radius = std::sqrt(50*50 + 80*80);
-		double theta = 30 + i * 50.0 / (frame-1 + 1e-10);
-		double x = -100 + radius * std::cos(theta * Math::PI / 180);
-		double y = -60 + radius * std::sin(theta * Math::PI / 180);
+// The film render under the profiler: writes a JSON summary, a chrome://tracing trace of the
+// tiles, and returns the heatmap of the time spent in every pixel.
+Matrix<uint8> globalIlluminationProfileTest(const Size& size, int samples) {
+	UnionGeometry geometries = globalIlluminationScene();
+	Film film(size.height(), size.width(), make_shared<GaussianFilter>());
 
-		auto sphere2 = make_shared<Sphere>(Vector3D(x, y, 20), 20);
-		sphere2->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
+	Profiler::begin(size.height(), size.width());
+	Render::pathTrace(geometries, globalIlluminationCamera(size), samples, film);
+	Profiler::end();
 
-		UnionGeometry geometries({ plane1, plane2, plane3, plane4, plane5, plane6, sphere1, sphere2, sphere3 });
+	cout << endl << Profiler::summary();
 
-		int w = 400;
-		int h = 300;
-		int samps = 10;
+	Profiler::saveSummary("E:\\profile.json");
+	Profiler::saveChromeTrace("E:\\trace.json");
 
-		clock_t start = clock();
+	return Profiler::heatmap();
+}
 
-		Matrix<uint8> mat = Render::pathTrace(geometries,
-											  PerspectiveCamera(Vector3D(120, 0, 50), Vector3D(-1, 0, 0), Vector3D(0, 0, 1), 40, (1.0 * w) / h),
-											  samps,
-											  Size(h, w, 3));
+Matrix<uint8> globalIlluminationDenoiseTest(const Size& size, int samples) {
+	AOV aov;
+	globalIlluminationTest(size, samples, &aov);
 
-		printf("\n%f sec\n", (float)(clock() - start) / CLOCKS_PER_SEC);
+	clock_t start = clock();
 
-		string filename = String::format("E:\\zzz\\%d.ppm", i);
-		PXMImage::save(mat, filename);
-	}
-}
+	Matrix<float> color;
+	IP::denoiseATrous(aov.color, color, aov.albedo, aov.normal, aov.depth, aov.id);
 
+	printf("denoise %f sec\n", (float)(clock() - start) / CLOCKS_PER_SEC);
 
-Matrix<uint8> renderICM(const Size& size, int samples) {
-	auto plane1 = make_shared<Plane>(Vector3D(0, 0, 1),    0);    // ground
-	auto plane2 = make_shared<Plane>(Vector3D(1, 0, 0),  -100);   // back
-	auto plane3 = make_shared<Plane>(Vector3D(0, 1, 0),  -60);    // left
-	auto plane4 = make_shared<Plane>(Vector3D(0, -1, 0), -60);    // right
-	auto plane5 = make_shared<Plane>(Vector3D(0, 0, -1), -100);   // ceil
-	auto plane6 = make_shared<Plane>(Vector3D(-1, 0, 0), -20);    // front
+	return cast<uint8>(clip(color, 0.0f, 1.0f) * 255 + 0.5f);
+}
+
+void globalIlluminationAnimation(const string& pattern = "E:\\zzz\\%d.ppm") {
+	auto plane1 = make_shared<Plane>(Vector3D(0, 0, 1), 0);    // ground
+	auto plane2 = make_shared<Plane>(Vector3D(1, 0, 0), -100);  // back
+	auto plane3 = make_shared<Plane>(Vector3D(0, 1, 0), -60);  // left
+	auto plane4 = make_shared<Plane>(Vector3D(0, -1, 0), -60); // right
+	auto plane5 = make_shared<Plane>(Vector3D(0, 0, -1), -100); // ceil
+	auto plane6 = make_shared<Plane>(Vector3D(-1, 0, 0), 0);   // front
 
 	plane1->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.75, 0.75), Color::BLACK, IdealType::DIFFUSE));
 	plane2->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.75, 0.75), Color::BLACK, IdealType::DIFFUSE));
@@ -213,84 +162,47 @@ Matrix<uint8> renderICM(const Size& size, int samples) {
 	plane5->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.75, 0.75), Color::BLACK, IdealType::DIFFUSE));
 	plane6->setMaterial(make_shared<IdealMaterial>(Color(0.50, 0.84, 0.81), Color::BLACK, IdealType::DIFFUSE));
 
-	auto sphere1 = make_shared<Sphere>(Vector3D(-60, -27.5, 20), 20);
-	auto sphere2 = make_shared<Sphere>(Vector3D(-45, 30, 20), 20);
+	auto sphere1 = make_shared<Sphere>(Vector3D(-70, -30, 20), 20);
+	auto sphere2 = make_shared<Sphere>(Vector3D(0, 0, 20), 20);
 	auto sphere3 = make_shared<Sphere>(Vector3D(-50, 0, 100 + 97), 100); // light
 
 	sphere1->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::SPECULAR));
 	sphere2->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
 	sphere3->setMaterial(make_shared<IdealMaterial>(Color(.75, .75, .75), Color(7.5, 7.5, 7.5), IdealType::DIFFUSE));
 
-	UnionGeometry geometries({ plane1, plane2, plane3, plane4, plane5, plane6, sphere1, sphere2, sphere3 });
-
-	double charX = 0, charY = 0, charZ = 70, r = 2;
-
-	// I 
-	for (int i = 0; i < 6; ++i) {
-		auto ball = make_shared<Sphere>(Vector3D(charX, -30 + charY, charZ - i*r*2), r);
-		ball->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
-		geometries.add(ball);
-	}
-
-	// C
-	double R = 10, theta1 = Math::PI / 4., theta2 = Math::PI * 7 / 4.;
-	double delta = 2*r/R;
-
-	for (double theta = theta1; theta < Math::PI; theta += delta) {
-		auto ball = make_shared<Sphere>(Vector3D(charX, -8 + charY + (R+1) * cos(theta), charZ-R + (R+1)*sin(theta)), r);
-		ball->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
-		geometries.add(ball);
-	}
-
-	auto ball = make_shared<Sphere>(Vector3D(charX, -8 + charY + (R+1) * cos(Math::PI), charZ - R + (R+1)*sin(Math::PI)), r);
-	ball->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
-	geometries.add(ball);
-
-	for (double theta = theta2; theta > Math::PI; theta -= delta) {
-		auto ball = make_shared<Sphere>(Vector3D(charX, -8 + charY + (R+1) * cos(theta), charZ - R + (R+1)*sin(theta)), r);
-		ball->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
-		geometries.add(ball);
-	}
+	int frame = 3;
 
-	// M
-	double mw = R*2;
-	for (int i = 0; i < 6; ++i) {
-		auto ball1 = make_shared<Sphere>(Vector3D(charX, 10 + charY, charZ - i*r * 2), r);
-		ball1->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
-
-		auto ball2 = make_shared<Sphere>(Vector3D(charX, 10 + mw + charY, charZ - i*r * 2), r);
-		ball2->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
-		
-		geometries.add(ball1);
-		geometries.add(ball2);
-	}
+	int w = 400;
+	int h = 300;
 
-	// ս
-	auto ball1 = make_shared<Sphere>(Vector3D(charX, 12 + charY, charZ-1), 2);
-	ball1->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
+	AnimationRenderer::Options options;
+	options.method = RenderJob::PATH_TRACE;
+	options.samples = 10;
+	options.size = Size(h, w, 3);
+	options.pattern = pattern;
+	options.accelerate = true;     // one sphere moves; the BVH of a frame is the last one refit
 
-	auto ball2 = make_shared<Sphere>(Vector3D(charX, 28 + charY, charZ-1), 2);
-	ball2->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
+	clock_t start = clock();
+	options.saved = [&](int i) { printf("frame %d: %f sec\n", i, (float)(clock() - start) / CLOCKS_PER_SEC); };
 
-	// սһ
-	auto ball3 = make_shared<Sphere>(Vector3D(charX, 10 + mw / 2 + charY, 54), 2);
-	ball3->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
+	AnimationRenderer animation({ plane1, plane2, plane3, plane4, plane5, plane6, sphere1, sphere2, sphere3 },
+								{},
+								PerspectiveCamera(Vector3D(120, 0, 50), Vector3D(-1, 0, 0), Vector3D(0, 0, 1), 40, (1.0 * w) / h),
+								options);
 
-	geometries.add(ball1);
-	geometries.add(ball2);
-	geometries.add(ball3);
+	animation.render(0, frame, [&](AnimationFrame& f) {
+		double radius = std::sqrt(50*50 + 80*80);
+		double theta = 30 + f.index * 50.0 / (frame-1 + 1e-10);
+		double x = -100 + radius * std::cos(theta * Math::PI / 180);
+		double y = -60 + radius * std::sin(theta * Math::PI / 180);
 
-	int num = 5;
-	for (int i = 1; i <= num; ++i) {
-		auto ball1 = make_shared<Sphere>(Vector3D(charX, 10 + mw/2 + charY - i*8./num, 54 + i*15./(num)), 2);
-		ball1->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
+		f.modify(sphere2)->setCenter(Vector3D(x, y, 20));
+	});
+}
 
-		auto ball2 = make_shared<Sphere>(Vector3D(charX, 10 + mw/2 + charY + i*8./num, 54 + i*15./(num)), 2);
-		ball2->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
 
-		geometries.add(ball1);
-		geometries.add(ball2);
-	}
+Matrix<uint8> renderICM(const Size& size, int samples) {
+	const UnionGeometry geometries = icmScene();
 
 	clock_t start = clock();
 
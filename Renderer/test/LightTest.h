@@ -15,6 +15,7 @@
 #include "PointLight.h"
 #include "SpotLight.h"
 #include "LambertMaterial.h"
+#include "Scenes.h"
 
 // ƽйԴ
 void directionalLightTest() {
@@ -111,24 +112,8 @@ void renderRGBTest() {
 
 // Դ
 void render36LightsTest() {
-	UnionGeometry geometries({
-		make_shared<Plane>(Vector3D(0, 1, 0), 0),
-		make_shared<Plane>(Vector3D(0, 0, 1), -50),
-		make_shared<Plane>(Vector3D(1, 0, 0), -20),
-		make_shared<Sphere>(Vector3D(0, 10, -10), 10)
-	});
-
-	vector<shared_ptr<Light>> lights;
-
-	for (int x = 10; x <= 30; x += 4) {
-		for (int z = 20; z <= 40; z += 4) {
-			lights.push_back(make_shared<PointLight>(Color::WHITE * 80, Vector3D(x, 50, z)));
-		}
-	}
-
-	auto fillLight = make_shared<DirectionalLight>(Color::WHITE*0.25, Vector3D(1.5, 1, 0.5));
-	lights.push_back(fillLight);
-
+	const UnionGeometry geometries = lights36Scene();
+	const vector<shared_ptr<Light>> lights = lights36Lights();
 
 	int w = 800;
 	int h = 600;
@@ -136,7 +121,7 @@ void render36LightsTest() {
 	Matrix<uint8> mat =
 		Render::renderLight(geometries,
 		lights,
-		PerspectiveCamera(Vector3D(0, 10, 10), Vector3D(0, 0, -1), Vector3D(0, 1, 0), 90, 1.*w / h),
+		lights36Camera(Size(h, w, 3)),
 		Size(h, w, 3));
 
 	PXMImage::save(mat, "E:\\render.ppm");
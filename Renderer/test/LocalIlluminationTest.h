@@ -7,6 +7,7 @@
 #include "Sphere.h"
 #include "PerspectiveCamera .h"
 #include "Render.h"
+#include "AnimationRenderer.h"
 #include "PhongMaterial.h"
 #include "Plane.h"
 #include "CheckerMaterial .h"
@@ -15,43 +16,22 @@
 #include "PointLight.h"
 #include "SpotLight.h"
 #include "LambertMaterial.h"
+#include "TextureMaterial.h"
+#include "MipMapTexture.h"
+#include "CachedTexture.h"
+#include "Scenes.h"
 
 // ӳ
 void planeAndSphereTest() {
-	auto plane1 = make_shared<Plane>(Vector3D(0, 0, 1), 0);    // bottom
-	auto plane2 = make_shared<Plane>(Vector3D(1, 0, 0), -20);  // back
-	auto plane3 = make_shared<Plane>(Vector3D(0, 1, 0), -30);  // left
-	auto plane4 = make_shared<Plane>(Vector3D(0, -1, 0), -30); // right
-	auto plane5 = make_shared<Plane>(Vector3D(0, 0, -1), -42); // top
-
-	// Two spheres
-	auto sphere1 = make_shared<Sphere>(Vector3D(-10, -12, 10), 10);
-	auto sphere2 = make_shared<Sphere>(Vector3D(-10, 12, 10), 10);
-
-	plane1->setMaterial(make_shared<CheckerMaterial>(0.1, 0.5));
-	plane2->setMaterial(make_shared<LambertMaterial>(Color(0, 0.5, 0.5)));
-	plane3->setMaterial(make_shared<LambertMaterial>(Color(0.5, 0.5, 0.5)));
-	plane4->setMaterial(make_shared<LambertMaterial>(Color(0, 0.2, 0.5)));
-	plane5->setMaterial(make_shared<LambertMaterial>(Color(0.25, 0.75, 0.25)));
-
-
-	sphere1->setMaterial(make_shared<PhongMaterial>(Color(1, 0, 0), Color::WHITE, 10, 0.25));
-	sphere2->setMaterial(make_shared<PhongMaterial>(Color(0.5, 0.5, 0.5), Color::WHITE, 16, 0.25));
-
-	UnionGeometry geometries({ plane1, plane2, plane3, plane4, plane5, sphere1, sphere2 });
-
-	vector<shared_ptr<Light>> lights{
-		make_shared<PointLight>(Color::WHITE * 800, Vector3D(20, -20, 40)),
-		make_shared<PointLight>(Color::WHITE * 800, Vector3D(20, 0, 40)),
-		make_shared<PointLight>(Color::WHITE * 800, Vector3D(20, 20, 40)),
-	};
+	const UnionGeometry geometries = planeAndSphereScene();
+	const vector<shared_ptr<Light>> lights = planeAndSphereLights();
 
 	int w = 800;
 	int h = 600;
 
 	Matrix<uint8> mat = Render::rayTrace(geometries,
 										 lights,
-										 PerspectiveCamera(Vector3D(20, 0, 20), Vector3D(-1, 0, 0), Vector3D(0, 0, 1), 90, 1.*w / h),
+										 planeAndSphereCamera(Size(h, w, 3)),
 										 50,
 										 Size(h, w, 3));
 
@@ -59,7 +39,7 @@ void planeAndSphereTest() {
 }
 
 // 
-void animationTest() {
+void animationTest(const string& pattern = "E:\\zzz\\%d.ppm") {
 	auto plane1 = make_shared<Plane>(Vector3D(0, 0, 1), 0);      // ground
 	auto plane2 = make_shared<Plane>(Vector3D(1, 0, 0), -20);    // back
 	auto plane3 = make_shared<Plane>(Vector3D(0, 1, 0), -29.9);  // left
@@ -72,43 +52,106 @@ void animationTest() {
 	plane4->setMaterial(make_shared<LambertMaterial>(Color(0, 0.5, 0.75)));
 	plane5->setMaterial(make_shared<PhongMaterial>(Color(0.75, 0.75, 0.75), Color(0.75, 0.75, 0.75), 50, 0));
 
-	int num = 180;
+	vector<shared_ptr<Light>> lights{
+		make_shared<PointLight>(Color::WHITE * 150, Vector3D(-15, -15, 41)),
+		make_shared<PointLight>(Color::WHITE * 150, Vector3D(-5, -15, 41)),
+		make_shared<PointLight>(Color::WHITE * 150, Vector3D(5, -15, 41)),
+		make_shared<PointLight>(Color::WHITE * 150, Vector3D(15, -15, 41)),
+		make_shared<PointLight>(Color::WHITE * 150, Vector3D(-15, 15, 41)),
+		make_shared<PointLight>(Color::WHITE * 150, Vector3D(-5, 15, 41)),
+		make_shared<PointLight>(Color::WHITE * 150, Vector3D(5, 15, 41)),
+		make_shared<PointLight>(Color::WHITE * 150, Vector3D(15, 15, 41)),
+	};
+
+	const int num = 180;
+	const double hh = 19.;
+
+	// Only the spheres move; every frame copies them and shares the rest.
+	auto sphere2 = make_shared<Sphere>(Vector3D(-10, 10, hh), 8);
+	auto sphere3 = make_shared<Sphere>(Vector3D(-10, -10, hh), 8);
 
-	for (int i = 0; i < num; ++i) {
-		const double delta = i * 2 * Math::PI / num;
-		const double hh = 19.;
+	sphere2->setMaterial(make_shared<PhongMaterial>(Color::RED, Color::RED, 10, 0.3));
+	sphere3->setMaterial(make_shared<PhongMaterial>(Color(0.5, 0.5, 0.5), Color(0.5, 0.5, 0.5), 10, 0.1));
+
+	AnimationRenderer::Options options;
+	options.method = RenderJob::RAY_TRACE;
+	options.maxReflect = 50;
+	options.size = Size(300, 400, 3);
+	options.pattern = pattern;
+
+	AnimationRenderer animation({ plane1, plane2, plane3, plane4, plane5, sphere2, sphere3 },
+								lights,
+								PerspectiveCamera(Vector3D(50, 0, 20), Vector3D(-1, 0, 0), Vector3D(0, 0, 1), 50, 400. / 300),
+								options);
+
+	animation.render(0, num, [&](AnimationFrame& frame) {
+		const double delta = frame.index * 2 * Math::PI / num;
 		const double z = hh + 10 * std::sin(delta);
 		const double y = 10 * std::cos(delta);
 
-		auto sphere2 = make_shared<Sphere>(Vector3D(-10, y, z), 8);
-		auto sphere3 = make_shared<Sphere>(Vector3D(-10, -y, 2 * hh - z), 8);
+		frame.modify(sphere2)->setCenter(Vector3D(-10, y, z));
+		frame.modify(sphere3)->setCenter(Vector3D(-10, -y, 2 * hh - z));
+	});
+}
+
+// A fine grid on a long floor, filtered by the width of the ray cones: it fades to gray in the
+// distance instead of breaking into moire.
+Matrix<uint8> gridImage() {
+	Matrix<uint8> image(256, 256, 3);
 
-		sphere2->setMaterial(make_shared<PhongMaterial>(Color::RED, Color::RED, 10, 0.3));
-		sphere3->setMaterial(make_shared<PhongMaterial>(Color(0.5, 0.5, 0.5), Color(0.5, 0.5, 0.5), 10, 0.1));
+	for (int i = 0; i < image.height(); ++i) {
+		for (int j = 0; j < image.width(); ++j) {
+			const bool line = i % 16 < 2 || j % 16 < 2;
 
-		UnionGeometry geometries({ plane1, plane2, plane3, plane4, plane5, sphere2, sphere3 });
+			image(i, j, 0) = line ? 230 : 40;
+			image(i, j, 1) = line ? 200 : 60;
+			image(i, j, 2) = line ? 40 : 120;
+		}
+	}
 
+	return image;
+}
 
-		vector<shared_ptr<Light>> lights{
-			make_shared<PointLight>(Color::WHITE * 150, Vector3D(-15, -15, 41)),
-			make_shared<PointLight>(Color::WHITE * 150, Vector3D(-5, -15, 41)),
-			make_shared<PointLight>(Color::WHITE * 150, Vector3D(5, -15, 41)),
-			make_shared<PointLight>(Color::WHITE * 150, Vector3D(15, -15, 41)),
-			make_shared<PointLight>(Color::WHITE * 150, Vector3D(-15, 15, 41)),
-			make_shared<PointLight>(Color::WHITE * 150, Vector3D(-5, 15, 41)),
-			make_shared<PointLight>(Color::WHITE * 150, Vector3D(5, 15, 41)),
-			make_shared<PointLight>(Color::WHITE * 150, Vector3D(15, 15, 41)),
-		};
+Matrix<uint8> renderTexturedFloor(const shared_ptr<Texture>& texture) {
+	auto floor = make_shared<Plane>(Vector3D(0, 0, 1), 0);
+	auto sphere = make_shared<Sphere>(Vector3D(-10, 0, 10), 10);
 
-		int w = 400;
-		int h = 300;
+	floor->setMaterial(make_shared<TextureMaterial>(texture, 0.05));
+	sphere->setMaterial(make_shared<PhongMaterial>(Color(0.5, 0.5, 0.5), Color::WHITE, 16, 0.5));
 
-		Matrix<uint8> mat = Render::rayTrace(geometries,
-											 lights,
-											 PerspectiveCamera(Vector3D(50, 0, 20), Vector3D(-1, 0, 0), Vector3D(0, 0, 1), 50, 1.*w / h),
-											 50,
-											 Size(h, w, 3));
-		string filename = String::format("E:\\zzz\\%d.ppm", i);
-		PXMImage::save(mat, filename);
-	}
-}
\ No newline at end of file
+	UnionGeometry geometries({ floor, sphere });
+
+	vector<shared_ptr<Light>> lights{
+		make_shared<DirectionalLight>(Color::WHITE, Vector3D(-1, 1, -2)),
+	};
+
+	int w = 800;
+	int h = 600;
+
+	return Render::rayTrace(geometries,
+							lights,
+							PerspectiveCamera(Vector3D(40, 0, 10), Vector3D(-1, 0, -0.15), Vector3D(0, 0, 1), 90, 1.*w / h),
+							5,
+							Size(h, w, 3));
+}
+
+void textureTest() {
+	Matrix<uint8> mat = renderTexturedFloor(make_shared<MipMapTexture>(gridImage()));
+
+	PXMImage::save(mat, "E:\\texture.ppm");
+}
+
+// The same through a texture cache of 64 KB, i.e. 4 tiles, read from the file on demand.
+void textureCacheTest() {
+	PXMImage::save(gridImage(), "E:\\grid.ppm");
+
+	auto cache = make_shared<TextureCache>(64 << 10);
+	Matrix<uint8> mat = renderTexturedFloor(make_shared<CachedTexture>(cache, "E:\\grid.ppm"));
+
+	const TextureCache::Statistics stats = cache->statistics();
+
+	cout << "texture cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+		 << stats.evictions << " evictions, " << stats.bytes << " bytes" << endl;
+
+	PXMImage::save(mat, "E:\\texture_cache.ppm");
+}
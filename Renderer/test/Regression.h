@@ -0,0 +1,363 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     Regression.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Performance regression harness over the canonical scenes, run by regress.cpp.
+//
+//                A faster renderer that converges worse is slower, so path traced scenes are scored
+//                at equal time: passes of 4 samples per pixel go into one film until the time budget
+//                is spent, and the result is compared to a high sample count reference. Monte Carlo
+//                error falls as 1 / time, so relMSE * seconds / targetRelMSE estimates the time to
+//                reach the target quality. Ray traced scenes are deterministic; their time to quality
+//                is the render time, provided the image matches the reference.
+//
+//                Every run appends one JSON line per scene to the history, and fails when the time to
+//                quality of a scene exceeds the median of its last runs at the same size by more than
+//                the threshold.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Scenes.h"
+#include "Render.h"
+#include "ConcurrentFilm.h"
+#include "Filter.h"
+#include "Profiler.h"
+#include "PXMImage.h"
+#include "MyString.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+
+class Regression {
+public:
+
+	struct Options {
+		Size size = Size(120, 160, 3);
+		double budgetSeconds = 10;       // per scene
+		std::string referenceDir = ".";
+		int referenceSamples = 4096;     // per pixel
+		std::string historyFile = "regression.jsonl";
+		double targetRelMSE = 0.01;
+		double threshold = 0.1;          // allowed growth of the time to quality
+		int baselineRuns = 5;            // recent runs the baseline is the median of
+		double maxRmse = 1.0 / 255;      // of deterministic scenes against their references
+		std::string filter;              // scenes whose name contains it
+		std::string label;               // e.g. a commit hash, stored in the history
+	};
+
+	struct Result {
+		std::string scene;
+		int passes;                      // renders into the film, or timed renders
+		int samplesPerPixel;
+		double wallSeconds;              // of all passes, or of the fastest render
+		uint64_t rays;
+		double raysPerSecond;
+		bool hasReference;
+		double rmse;
+		double relMSE;
+		double secondsToTarget;          // time to quality; infinite when a deterministic image differs
+		double baselineSeconds;          // 0 without history
+		bool regressed;
+		uint64_t peakMemory;             // bytes, of the whole process so far
+	};
+
+	explicit Regression(const Options& options) : _options(options) {}
+
+	// Renders the references of the selected scenes.
+	void makeReferences();
+
+	// Renders every selected scene, appends to the history and returns the results.
+	std::vector<Result> run();
+
+	static uint64_t peakMemory();
+
+	static double rmse(const Matrix<float>& image, const Matrix<float>& reference);
+
+	// Squared error relative to the squared reference, so dark and bright regions weigh alike.
+	static double relMSE(const Matrix<float>& image, const Matrix<float>& reference);
+
+	static std::string json(const Result& result, const Options& options);
+
+private:
+	std::vector<Scene> scenes() const;
+
+	std::string referencePath(const Scene& scene) const {
+		return String::format("%s/%s_%dx%d.pfm", _options.referenceDir.c_str(), scene.name.c_str(), _options.size.width(), _options.size.height());
+	}
+
+	static double seconds(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	static Matrix<float> toFloat(const Matrix<uint8>& image);
+
+	Matrix<float> renderDeterministic(const Scene& scene, Result& result) const;
+
+	Matrix<float> renderProgressive(const Scene& scene, Result& result) const;
+
+	// Median time to quality of the last runs of 'scene' at the same size.
+	double baseline(const std::string& scene) const;
+
+	Options _options;
+};
+
+
+std::vector<Scene> Regression::scenes() const {
+	std::vector<Scene> all = canonicalScenes(), selected;
+
+	for (const Scene& scene : all)
+		if (scene.name.find(_options.filter) != std::string::npos) selected.push_back(scene);
+
+	return selected;
+}
+
+uint64_t Regression::peakMemory() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+
+	return (uint64_t)counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+
+#ifdef __APPLE__
+	return (uint64_t)usage.ru_maxrss;
+#else
+	return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+double Regression::rmse(const Matrix<float>& image, const Matrix<float>& reference) {
+	if (!(size(image) == size(reference))) throw Exception("Image and reference differ in size!");
+
+	double sum = 0;
+
+	for (int i = 0; i < image.length(); ++i) {
+		const double d = image.data()[i] - reference.data()[i];
+		sum += d * d;
+	}
+
+	return std::sqrt(sum / image.length());
+}
+
+double Regression::relMSE(const Matrix<float>& image, const Matrix<float>& reference) {
+	if (!(size(image) == size(reference))) throw Exception("Image and reference differ in size!");
+
+	double sum = 0;
+
+	for (int i = 0; i < image.length(); ++i) {
+		const double r = reference.data()[i];
+		const double d = image.data()[i] - r;
+		sum += d * d / (r * r + 1e-2);
+	}
+
+	return sum / image.length();
+}
+
+Matrix<float> Regression::toFloat(const Matrix<uint8>& image) {
+	Matrix<float> m(image.height(), image.width(), image.channel());
+
+	for (int i = 0; i < image.length(); ++i)
+		m.data()[i] = image.data()[i] / 255.f;
+
+	return m;
+}
+
+Matrix<float> Regression::renderDeterministic(const Scene& scene, Result& result) const {
+	const PerspectiveCamera camera = scene.camera(_options.size);
+	const auto start = std::chrono::steady_clock::now();
+	Matrix<uint8> image;
+
+	// Repeated within the budget; the fastest render counts.
+	result.passes = 0;
+	result.wallSeconds = std::numeric_limits<double>::infinity();
+
+	do {
+		const auto renderStart = std::chrono::steady_clock::now();
+
+		if (scene.method == Scene::RAY_TRACE)
+			image = Render::rayTrace(scene.geometry, scene.lights, camera, scene.maxReflect, _options.size);
+		else
+			image = Render::renderLight(scene.geometry, scene.lights, camera, _options.size);
+
+		result.wallSeconds = std::min(result.wallSeconds, seconds(renderStart));
+		++result.passes;
+	} while (seconds(start) < _options.budgetSeconds);
+
+	result.samplesPerPixel = 1;
+
+	return toFloat(image);
+}
+
+Matrix<float> Regression::renderProgressive(const Scene& scene, Result& result) const {
+	const PerspectiveCamera camera = scene.camera(_options.size);
+	ConcurrentFilm film(_options.size.height(), _options.size.width(), make_shared<GaussianFilter>());
+	const auto start = std::chrono::steady_clock::now();
+
+	// Every pass is a frame of its own, so passes draw independent samples.
+	result.passes = 0;
+
+	do {
+		Render::pathTrace(scene.geometry, camera, 1, film, result.passes++);
+	} while (seconds(start) < _options.budgetSeconds);
+
+	result.wallSeconds = seconds(start);
+	result.samplesPerPixel = result.passes * 4;
+
+	return film.linear();
+}
+
+void Regression::makeReferences() {
+	for (const Scene& scene : scenes()) {
+		const std::string path = referencePath(scene);
+		const auto start = std::chrono::steady_clock::now();
+		Matrix<float> reference;
+
+		if (scene.method == Scene::PATH_TRACE) {
+			ConcurrentFilm film(_options.size.height(), _options.size.width(), make_shared<GaussianFilter>());
+
+			// A frame no regression pass reaches, so the reference is independent of the runs.
+			Render::pathTrace(scene.geometry, scene.camera(_options.size), std::max(1, _options.referenceSamples / 4), film, 0x7fffffff);
+			reference = film.linear();
+		} else {
+			Result unused;
+			Options once = _options;
+			once.budgetSeconds = 0;
+			reference = Regression(once).renderDeterministic(scene, unused);
+		}
+
+		PXMImage::saveFloat(reference, path);
+		printf("%-20s reference %s in %.1f sec\n", scene.name.c_str(), path.c_str(), seconds(start));
+	}
+}
+
+double Regression::baseline(const std::string& scene) const {
+	std::ifstream file(_options.historyFile);
+	std::string line;
+	std::vector<double> times;
+
+	const std::string sceneKey = "\"scene\": \"" + scene + "\"";
+	const std::string sizeKey = String::format("\"width\": %d, \"height\": %d", _options.size.width(), _options.size.height());
+
+	// Lines are written by json() alone, so the keys are found by their exact text.
+	while (std::getline(file, line)) {
+		const size_t p = line.find("\"secondsToTarget\": ");
+
+		if (line.find(sceneKey) == std::string::npos || line.find(sizeKey) == std::string::npos || p == std::string::npos) continue;
+
+		const double t = atof(line.c_str() + p + 19);
+
+		if (t > 0 && t < std::numeric_limits<double>::infinity()) times.push_back(t);
+	}
+
+	if (times.empty()) return 0;
+
+	const int n = std::min((int)times.size(), _options.baselineRuns);
+	std::vector<double> recent(times.end() - n, times.end());
+
+	std::sort(recent.begin(), recent.end());
+
+	return recent[n / 2];
+}
+
+std::vector<Regression::Result> Regression::run() {
+	std::vector<Result> results;
+
+	for (const Scene& scene : scenes()) {
+		Result result;
+		result.scene = scene.name;
+
+		Profiler::begin(_options.size.height(), _options.size.width());
+
+		const Matrix<float> image = scene.method == Scene::PATH_TRACE ? renderProgressive(scene, result) : renderDeterministic(scene, result);
+
+		Profiler::end();
+
+		result.rays = Profiler::total().rays;
+		result.raysPerSecond = result.rays / Profiler::wallSeconds();
+		result.peakMemory = peakMemory();
+
+		const std::string path = referencePath(scene);
+		result.hasReference = std::ifstream(path).good();
+		result.rmse = result.relMSE = 0;
+
+		if (result.hasReference) {
+			const Matrix<float> reference = PXMImage::openFloat(path);
+
+			result.rmse = rmse(image, reference);
+			result.relMSE = relMSE(image, reference);
+
+			if (scene.method == Scene::PATH_TRACE)
+				result.secondsToTarget = result.relMSE * result.wallSeconds / _options.targetRelMSE;
+			else
+				result.secondsToTarget = result.rmse <= _options.maxRmse ? result.wallSeconds : std::numeric_limits<double>::infinity();
+		} else {
+			// Without a reference only the speed of deterministic scenes can be judged.
+			result.secondsToTarget = scene.method == Scene::PATH_TRACE ? 0 : result.wallSeconds;
+		}
+
+		result.baselineSeconds = baseline(scene.name);
+		result.regressed = result.baselineSeconds > 0 && result.secondsToTarget > result.baselineSeconds * (1 + _options.threshold);
+
+		printf("%-20s %5d spp %8.2f sec %8.3f Mrays/s  rmse %.5f  relMSE %.6f  to target %9.3f sec  baseline %9.3f sec%s%s\n",
+			scene.name.c_str(), result.samplesPerPixel, result.wallSeconds, result.raysPerSecond * 1e-6, result.rmse, result.relMSE,
+			result.secondsToTarget, result.baselineSeconds, result.hasReference ? "" : "  (no reference)", result.regressed ? "  REGRESSED" : "");
+		fflush(stdout);
+
+		results.push_back(result);
+	}
+
+	if (!_options.historyFile.empty()) {
+		std::ofstream file(_options.historyFile, std::ios::app);
+
+		for (const Result& result : results)
+			file << json(result, _options) << "\n";
+	}
+
+	return results;
+}
+
+std::string Regression::json(const Result& r, const Options& options) {
+	char date[32];
+	const std::time_t now = std::time(nullptr);
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+	// JSON has no infinity; a failed deterministic scene is stored as -1. Both it and 0, for a
+	// scene without a reference, are left out of baselines.
+	const double secondsToTarget = r.secondsToTarget < std::numeric_limits<double>::infinity() ? r.secondsToTarget : -1;
+
+	return String::format("{\"date\": \"%s\", \"label\": \"%s\", \"scene\": \"%s\", \"width\": %d, \"height\": %d, \"budgetSeconds\": %g, "
+		"\"passes\": %d, \"samplesPerPixel\": %d, \"wallSeconds\": %.6f, \"rays\": %llu, \"raysPerSecond\": %.0f, \"rmse\": %.6g, "
+		"\"relMSE\": %.6g, \"secondsToTarget\": %.6g, \"targetRelMSE\": %g, \"peakMemoryBytes\": %llu}",
+		date, options.label.c_str(), r.scene.c_str(), options.size.width(), options.size.height(), options.budgetSeconds,
+		r.passes, r.samplesPerPixel, r.wallSeconds, (unsigned long long)r.rays, r.raysPerSecond, r.rmse,
+		r.relMSE, secondsToTarget, options.targetRelMSE, (unsigned long long)r.peakMemory);
+}
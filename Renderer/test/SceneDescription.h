@@ -0,0 +1,245 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     SceneDescription.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   A scene as plain data: camera, materials, spheres, planes and lights. build() turns
+//                it into a Scene for the renderers, and it is saved to and loaded from text files.
+//
+//                Materials are kept in a table and shared by index, so scenes of millions of spheres
+//                hold a few materials, not millions. They are described by their ideal type; build()
+//                maps them to Lambert and Phong materials for the ray tracers, which cannot use
+//                IdealMaterial.
+//
+//                The file has one record per line; '#' starts a comment.
+//
+//                    name       <word>
+//                    method     path | ray <maxReflect> | light
+//                    camera     <eye x y z> <front x y z> <up x y z> <fov>
+//                    material   diffuse | specular | refractive <color r g b> <emission r g b>
+//                    sphere     <center x y z> <radius> <material>
+//                    plane      <normal x y z> <d> <material>
+//                    point      <intensity r g b> <position x y z>
+//                    directional <irradiance r g b> <direction x y z>
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Scenes.h"
+#include "MyException.h"
+#include "MyString.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct SceneDescription {
+	struct MaterialRecord {
+		IdealType type;
+		Color color;
+		Color emission;
+	};
+
+	struct SphereRecord {
+		Vector3D center;
+		double radius;
+		int material;
+	};
+
+	struct PlaneRecord {
+		Vector3D normal;
+		double d;
+		int material;
+	};
+
+	struct LightRecord {
+		bool directional;
+		Color color;
+		Vector3D vector;    // position of a point light, direction of a directional one
+	};
+
+	std::string name = "scene";
+	Scene::Method method = Scene::PATH_TRACE;
+	int maxReflect = 3;
+
+	Vector3D eye = Vector3D(10, 0, 5), front = Vector3D(-1, 0, 0), up = Vector3D(0, 0, 1);
+	double fov = 40;
+
+	std::vector<MaterialRecord> materials;
+	std::vector<SphereRecord> spheres;
+	std::vector<PlaneRecord> planes;
+	std::vector<LightRecord> lights;
+
+	int addMaterial(IdealType type, const Color& color, const Color& emission = Color::BLACK) {
+		materials.push_back(MaterialRecord{ type, color, emission });
+		return (int)materials.size() - 1;
+	}
+
+	void addSphere(const Vector3D& center, double radius, int material) { spheres.push_back(SphereRecord{ center, radius, material }); }
+
+	void addPlane(const Vector3D& normal, double d, int material) { planes.push_back(PlaneRecord{ normal, d, material }); }
+
+	void addPointLight(const Color& intensity, const Vector3D& position) { lights.push_back(LightRecord{ false, intensity, position }); }
+
+	void addDirectionalLight(const Color& irradiance, const Vector3D& direction) { lights.push_back(LightRecord{ true, irradiance, direction }); }
+
+	size_t primitives() const { return spheres.size() + planes.size(); }
+
+	// Geometry, lights and camera for the renderer of 'method'.
+	Scene build() const;
+
+	void save(const std::string& filepath) const;
+
+	static SceneDescription load(const std::string& filepath);
+};
+
+
+Scene SceneDescription::build() const {
+	std::vector<shared_ptr<Material>> table;
+
+	for (const MaterialRecord& m : materials) {
+		if (method == Scene::PATH_TRACE)
+			table.push_back(make_shared<IdealMaterial>(m.color, m.emission, m.type));
+		else if (m.type == IdealType::DIFFUSE)
+			table.push_back(make_shared<LambertMaterial>(m.color));
+		else
+			table.push_back(make_shared<PhongMaterial>(m.color, Color::WHITE, 32, m.type == IdealType::SPECULAR ? 0.8 : 0.4));
+	}
+
+	auto material = [&](int index) -> const shared_ptr<Material>& {
+		if (index < 0 || index >= (int)table.size()) throw Exception(String::format("Material %d does not exist!", index));
+		return table[index];
+	};
+
+	vector<shared_ptr<Geometry>> geometries;
+	geometries.reserve(primitives());
+
+	for (const PlaneRecord& p : planes)
+		geometries.push_back(make_shared<Plane>(p.normal, p.d, material(p.material)));
+
+	for (const SphereRecord& s : spheres)
+		geometries.push_back(make_shared<Sphere>(s.center, s.radius, material(s.material)));
+
+	vector<shared_ptr<Light>> sceneLights;
+
+	for (const LightRecord& l : lights) {
+		if (l.directional)
+			sceneLights.push_back(make_shared<DirectionalLight>(l.color, l.vector));
+		else
+			sceneLights.push_back(make_shared<PointLight>(l.color, l.vector));
+	}
+
+	const Vector3D eye = this->eye, front = this->front, up = this->up;
+	const double fov = this->fov;
+
+	return Scene(name, method, UnionGeometry(geometries), [=](const Size& size) {
+		return PerspectiveCamera(eye, front, up, fov, (1.0 * size.width()) / size.height());
+	}, sceneLights, maxReflect);
+}
+
+void SceneDescription::save(const std::string& filepath) const {
+	FILE* file = fopen(filepath.c_str(), "w");
+
+	if (!file) throw Exception("Can not open " + filepath + "!");
+
+	static const char* methods[] = { "path", "ray", "light" };
+	static const char* types[] = { "diffuse", "specular", "refractive" };
+
+	fprintf(file, "# %llu primitives, %llu lights\n", (unsigned long long)primitives(), (unsigned long long)lights.size());
+	fprintf(file, "name %s\n", name.c_str());
+	fprintf(file, method == Scene::RAY_TRACE ? "method %s %d\n" : "method %s\n", methods[method], maxReflect);
+	fprintf(file, "camera %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g\n",
+		eye.x(), eye.y(), eye.z(), front.x(), front.y(), front.z(), up.x(), up.y(), up.z(), fov);
+
+	for (const MaterialRecord& m : materials)
+		fprintf(file, "material %s %.17g %.17g %.17g %.17g %.17g %.17g\n", types[(int)m.type],
+			m.color.r, m.color.g, m.color.b, m.emission.r, m.emission.g, m.emission.b);
+
+	for (const PlaneRecord& p : planes)
+		fprintf(file, "plane %.17g %.17g %.17g %.17g %d\n", p.normal.x(), p.normal.y(), p.normal.z(), p.d, p.material);
+
+	for (const SphereRecord& s : spheres)
+		fprintf(file, "sphere %.17g %.17g %.17g %.17g %d\n", s.center.x(), s.center.y(), s.center.z(), s.radius, s.material);
+
+	for (const LightRecord& l : lights)
+		fprintf(file, "%s %.17g %.17g %.17g %.17g %.17g %.17g\n", l.directional ? "directional" : "point",
+			l.color.r, l.color.g, l.color.b, l.vector.x(), l.vector.y(), l.vector.z());
+
+	fclose(file);
+}
+
+SceneDescription SceneDescription::load(const std::string& filepath) {
+	std::ifstream file(filepath);
+
+	if (!file) throw Exception("Can not open " + filepath + "!");
+
+	SceneDescription scene;
+	std::string line, record;
+	int lineNumber = 0;
+
+	auto readVector = [](std::istringstream& in) { double x, y, z; in >> x >> y >> z; return Vector3D(x, y, z); };
+	auto readColor = [](std::istringstream& in) { double r, g, b; in >> r >> g >> b; return Color(r, g, b); };
+
+	while (std::getline(file, line)) {
+		++lineNumber;
+
+		std::istringstream in(line);
+
+		if (!(in >> record) || record[0] == '#') continue;
+
+		if (record == "name") {
+			in >> scene.name;
+		} else if (record == "method") {
+			std::string method;
+			in >> method;
+
+			if (method == "path") scene.method = Scene::PATH_TRACE;
+			else if (method == "ray") { scene.method = Scene::RAY_TRACE; in >> scene.maxReflect; }
+			else if (method == "light") scene.method = Scene::RENDER_LIGHT;
+			else in.setstate(std::ios::failbit);
+		} else if (record == "camera") {
+			scene.eye = readVector(in);
+			scene.front = readVector(in);
+			scene.up = readVector(in);
+			in >> scene.fov;
+		} else if (record == "material") {
+			std::string type;
+			in >> type;
+
+			const Color color = readColor(in), emission = readColor(in);
+
+			if (type == "diffuse") scene.addMaterial(IdealType::DIFFUSE, color, emission);
+			else if (type == "specular") scene.addMaterial(IdealType::SPECULAR, color, emission);
+			else if (type == "refractive") scene.addMaterial(IdealType::REFRACTIVE, color, emission);
+			else in.setstate(std::ios::failbit);
+		} else if (record == "sphere") {
+			SphereRecord s;
+			s.center = readVector(in);
+			in >> s.radius >> s.material;
+			scene.spheres.push_back(s);
+		} else if (record == "plane") {
+			PlaneRecord p;
+			p.normal = readVector(in);
+			in >> p.d >> p.material;
+			scene.planes.push_back(p);
+		} else if (record == "point" || record == "directional") {
+			const Color color = readColor(in);
+			scene.lights.push_back(LightRecord{ record == "directional", color, readVector(in) });
+		} else {
+			in.setstate(std::ios::failbit);
+		}
+
+		if (in.fail()) throw Exception(String::format("%s:%d: can not parse '%s'!", filepath.c_str(), lineNumber, line.c_str()));
+	}
+
+	return scene;
+}
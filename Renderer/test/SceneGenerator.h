@@ -0,0 +1,331 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     SceneGenerator.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   Procedural stress scenes, from a thousand to tens of millions of primitives, to
+//                measure acceleration structures, memory and thread scaling.
+//
+//                    sphereField    random spheres, uniform, in clusters or on the ground
+//                    sphereFlake    spheres with 9 children a third their size, recursively
+//                    instanceGrid   a grid of copies of one random cluster of spheres
+//                    lightArray     a grid of lights over a field of spheres
+//                    glassStack     a row of glass spheres along the view
+//
+//                Every generator is a function of its arguments and the seed alone, and frames its
+//                scene with the camera. Scenes stand on a ground plane; path traced ones are lit by an
+//                emissive sky sphere, ray traced ones by a sun and a point light.
+//
+//                The renderer has no transforms, so the copies of instanceGrid are separate spheres
+//                sharing materials, not instances.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneDescription.h"
+#include "MyMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+class SceneGenerator {
+public:
+
+	enum Distribution { UNIFORM, CLUSTERED, GROUND };
+
+	// Relative weights of the materials of generated spheres.
+	struct MaterialMix {
+		double diffuse, specular, refractive, emissive;
+
+		MaterialMix(double diffuse = 0.6, double specular = 0.2, double refractive = 0.2, double emissive = 0)
+			: diffuse(diffuse), specular(specular), refractive(refractive), emissive(emissive)
+		{}
+	};
+
+	// 'count' spheres in a region that grows with the count, so the density stays the same.
+	static SceneDescription sphereField(int count, Distribution distribution = UNIFORM, const MaterialMix& mix = MaterialMix(),
+		Scene::Method method = Scene::PATH_TRACE, uint32_t seed = 1);
+
+	// (9^(depth + 1) - 1) / 8 spheres: 820 at depth 3, 5380840 at depth 7.
+	static SceneDescription sphereFlake(int depth, const MaterialMix& mix = MaterialMix(), Scene::Method method = Scene::PATH_TRACE, uint32_t seed = 1);
+
+	// nx * ny * nz copies of a cluster of 'cluster' spheres.
+	static SceneDescription instanceGrid(int nx, int ny, int nz, int cluster = 16, const MaterialMix& mix = MaterialMix(),
+		Scene::Method method = Scene::PATH_TRACE, uint32_t seed = 1);
+
+	// 'count' lights over a field of spheres: point lights for the ray tracers, small emissive
+	// spheres for the path tracer, which has no other lights. Their total power is fixed.
+	static SceneDescription lightArray(int count, Scene::Method method = Scene::RENDER_LIGHT, uint32_t seed = 1);
+
+	// 'layers' glass spheres in a row along the view, so camera rays cross 2 * layers surfaces.
+	static SceneDescription glassStack(int layers, Scene::Method method = Scene::PATH_TRACE, uint32_t seed = 1);
+
+private:
+	// Materials of generated spheres: a few of every kind, picked by the weights of 'mix'.
+	class Palette {
+	public:
+		Palette(SceneDescription& scene, const MaterialMix& mix, std::mt19937& mt);
+
+		int pick(std::mt19937& mt);
+
+	private:
+		static const int perKind = 8;
+
+		std::vector<int> _materials[4];
+		std::discrete_distribution<int> _kind;
+	};
+
+	// Ground plane, and the lights of 'method' unless 'lit' is false.
+	static SceneDescription stage(const std::string& name, Scene::Method method, bool lit = true);
+
+	// Points the camera at the box (lo, hi) from the front right, above.
+	static void frame(SceneDescription& scene, const Vector3D& lo, const Vector3D& hi);
+};
+
+
+SceneGenerator::Palette::Palette(SceneDescription& scene, const MaterialMix& mix, std::mt19937& mt)
+	: _kind({ mix.diffuse, mix.specular, mix.refractive, mix.emissive })
+{
+	if (!(mix.diffuse >= 0 && mix.specular >= 0 && mix.refractive >= 0 && mix.emissive >= 0) || mix.diffuse + mix.specular + mix.refractive + mix.emissive <= 0)
+		throw Exception("Material weights must be non-negative, and not all zero!");
+
+	std::uniform_real_distribution<double> dist(0.1, 0.9);
+
+	for (int i = 0; i < perKind; ++i) {
+		const Color color(dist(mt), dist(mt), dist(mt));
+
+		_materials[0].push_back(scene.addMaterial(IdealType::DIFFUSE, color));
+		_materials[1].push_back(scene.addMaterial(IdealType::SPECULAR, color * 0.5 + Color::WHITE * 0.49));
+		_materials[2].push_back(scene.addMaterial(IdealType::REFRACTIVE, Color::WHITE * 0.999));
+		_materials[3].push_back(scene.addMaterial(IdealType::DIFFUSE, color, color * 4));
+	}
+}
+
+int SceneGenerator::Palette::pick(std::mt19937& mt) {
+	const int kind = _kind(mt);
+
+	return _materials[kind][mt() % perKind];
+}
+
+SceneDescription SceneGenerator::stage(const std::string& name, Scene::Method method, bool lit) {
+	SceneDescription scene;
+	scene.name = name;
+	scene.method = method;
+
+	scene.addPlane(Vector3D(0, 0, 1), 0, scene.addMaterial(IdealType::DIFFUSE, Color(0.5, 0.5, 0.5)));
+
+	if (!lit) return scene;
+
+	if (method == Scene::PATH_TRACE) {
+		scene.addSphere(Vector3D(0, 0, 0), 1e6, scene.addMaterial(IdealType::DIFFUSE, Color::BLACK, Color(0.9, 0.95, 1.0)));
+	} else {
+		scene.addDirectionalLight(Color::WHITE * 0.8, Vector3D(-1, -0.5, -2));
+		scene.addPointLight(Color::WHITE * 2000, Vector3D(30, -30, 60));
+	}
+
+	return scene;
+}
+
+void SceneGenerator::frame(SceneDescription& scene, const Vector3D& lo, const Vector3D& hi) {
+	const Vector3D center = (lo + hi) * 0.5;
+	const double radius = std::max((hi - lo).length() * 0.5, 1e-3);
+	const Vector3D direction = Vector3D(1, 0.6, 0.6).norm();
+
+	scene.fov = 40;
+	scene.eye = center + direction * (radius / std::sin(scene.fov * 0.5 * Math::PI / 180));
+	scene.front = direction * -1;
+	scene.up = Vector3D(0, 0, 1);
+}
+
+
+SceneDescription SceneGenerator::sphereField(int count, Distribution distribution, const MaterialMix& mix, Scene::Method method, uint32_t seed) {
+	if (count <= 0)
+		throw Exception("Sphere field of no spheres!");
+
+	SceneDescription scene = stage(String::format("sphereField%d", count), method);
+	std::mt19937 mt(seed);
+	Palette palette(scene, mix, mt);
+
+	// About one sphere in every 8 units of volume, or of area on the ground.
+	const double side = distribution == GROUND ? std::sqrt(8.0 * count) : std::cbrt(16.0 * count);
+	const double height = distribution == GROUND ? 1 : side / 2;
+
+	std::uniform_real_distribution<double> unit(0, 1);
+	std::normal_distribution<double> normal(0, side / 20);
+	std::vector<Vector3D> clusters;
+
+	for (int i = 0; i < count / 1000 + 1; ++i)
+		clusters.push_back(Vector3D((unit(mt) - 0.5) * side, (unit(mt) - 0.5) * side, unit(mt) * height));
+
+	scene.spheres.reserve(scene.spheres.size() + count);
+
+	for (int i = 0; i < count; ++i) {
+		const double radius = 0.25 + 0.25 * unit(mt);
+		Vector3D center;
+
+		if (distribution == UNIFORM) {
+			center = Vector3D((unit(mt) - 0.5) * side, (unit(mt) - 0.5) * side, radius + unit(mt) * height);
+		} else if (distribution == CLUSTERED) {
+			const Vector3D& c = clusters[mt() % clusters.size()];
+			center = Vector3D(c.x() + normal(mt), c.y() + normal(mt), std::max(radius, c.z() + normal(mt)));
+		} else {
+			center = Vector3D((unit(mt) - 0.5) * side, (unit(mt) - 0.5) * side, radius);
+		}
+
+		scene.addSphere(center, radius, palette.pick(mt));
+	}
+
+	frame(scene, Vector3D(-side / 2, -side / 2, 0), Vector3D(side / 2, side / 2, height + 0.5));
+
+	return scene;
+}
+
+SceneDescription SceneGenerator::sphereFlake(int depth, const MaterialMix& mix, Scene::Method method, uint32_t seed) {
+	if (depth < 0)
+		throw Exception("Sphere flake of negative depth!");
+
+	SceneDescription scene = stage(String::format("sphereFlake%d", depth), method);
+	std::mt19937 mt(seed);
+	Palette palette(scene, mix, mt);
+
+	// Children directions in the frame of the parent direction (0, 0, 1): 6 around the equator, 3 above.
+	std::vector<Vector3D> children;
+
+	for (int i = 0; i < 6; ++i)
+		children.push_back(Vector3D(std::cos(i * Math::PI / 3), std::sin(i * Math::PI / 3), 0));
+
+	for (int i = 0; i < 3; ++i)
+		children.push_back(Vector3D(std::cos(i * 2 * Math::PI / 3 + Math::PI / 6) * 0.5, std::sin(i * 2 * Math::PI / 3 + Math::PI / 6) * 0.5, std::sqrt(0.75)));
+
+	struct Node { Vector3D center, direction; double radius; int level; };
+	std::vector<Node> stack{ Node{ Vector3D(0, 0, 1), Vector3D(0, 0, 1), 1, 0 } };
+
+	while (!stack.empty()) {
+		const Node node = stack.back();
+		stack.pop_back();
+
+		scene.addSphere(node.center, node.radius, palette.pick(mt));
+
+		if (node.level == depth) continue;
+
+		const Vector3D& w = node.direction;
+		const Vector3D u = ((std::abs(w.x()) > 0.1 ? Vector3D::Yaxis : Vector3D::Xaxis).cross(w)).norm();
+		const Vector3D v = w.cross(u);
+		const double radius = node.radius / 3;
+
+		for (const Vector3D& c : children) {
+			const Vector3D d = (u * c.x() + v * c.y() + w * c.z()).norm();
+			stack.push_back(Node{ node.center + d * (node.radius + radius), d, radius, node.level + 1 });
+		}
+	}
+
+	frame(scene, Vector3D(-2, -2, 0), Vector3D(2, 2, 3));
+
+	return scene;
+}
+
+SceneDescription SceneGenerator::instanceGrid(int nx, int ny, int nz, int cluster, const MaterialMix& mix, Scene::Method method, uint32_t seed) {
+	if (nx <= 0 || ny <= 0 || nz <= 0 || cluster <= 0)
+		throw Exception("Instance grid of no instances, or of empty clusters!");
+
+	SceneDescription scene = stage(String::format("instanceGrid%dx%dx%d", nx, ny, nz), method);
+	std::mt19937 mt(seed);
+	Palette palette(scene, mix, mt);
+	std::uniform_real_distribution<double> unit(0, 1);
+
+	// One random cluster in a cell of 4 x 4 x 4, copied into every cell.
+	const double cell = 4;
+	std::vector<SceneDescription::SphereRecord> prototype;
+
+	for (int i = 0; i < cluster; ++i) {
+		const double radius = 0.2 + 0.3 * unit(mt);
+		const Vector3D center(radius + unit(mt) * (cell - 2 * radius), radius + unit(mt) * (cell - 2 * radius), radius + unit(mt) * (cell - 2 * radius));
+
+		prototype.push_back(SceneDescription::SphereRecord{ center, radius, palette.pick(mt) });
+	}
+
+	const Vector3D origin(-nx * cell / 2, -ny * cell / 2, 0);
+
+	scene.spheres.reserve(scene.spheres.size() + (size_t)nx * ny * nz * cluster);
+
+	for (int k = 0; k < nz; ++k)
+		for (int j = 0; j < ny; ++j)
+			for (int i = 0; i < nx; ++i)
+				for (const auto& s : prototype)
+					scene.addSphere(origin + Vector3D(i * cell, j * cell, k * cell) + s.center, s.radius, s.material);
+
+	frame(scene, origin, origin + Vector3D(nx * cell, ny * cell, nz * cell));
+
+	return scene;
+}
+
+SceneDescription SceneGenerator::lightArray(int count, Scene::Method method, uint32_t seed) {
+	if (count <= 0)
+		throw Exception("Light array of no lights!");
+
+	SceneDescription scene = stage(String::format("lightArray%d", count), method, false);
+	std::mt19937 mt(seed);
+	Palette palette(scene, MaterialMix(), mt);
+	std::uniform_real_distribution<double> unit(0, 1);
+
+	// 64 spheres on the ground, under a square grid of lights.
+	const double side = 32;
+
+	for (int i = 0; i < 64; ++i) {
+		const double radius = 1 + unit(mt);
+		scene.addSphere(Vector3D((unit(mt) - 0.5) * side, (unit(mt) - 0.5) * side, radius), radius, palette.pick(mt));
+	}
+
+	const int n = std::max(1, (int)std::ceil(std::sqrt((double)count)));
+	const double spacing = side / n;
+	const double power = 1.0 / count;
+	const int lamp = scene.addMaterial(IdealType::DIFFUSE, Color::BLACK, Color::WHITE * (power * 4e3 / (spacing * spacing)));
+
+	for (int i = 0; i < count; ++i) {
+		const Vector3D position(((i % n) + 0.5) * spacing - side / 2, ((i / n) + 0.5) * spacing - side / 2, 12);
+
+		if (method == Scene::PATH_TRACE)
+			scene.addSphere(position, spacing * 0.25, lamp);
+		else
+			scene.addPointLight(Color::WHITE * (power * 200), position);
+	}
+
+	frame(scene, Vector3D(-side / 2, -side / 2, 0), Vector3D(side / 2, side / 2, 12));
+
+	return scene;
+}
+
+SceneDescription SceneGenerator::glassStack(int layers, Scene::Method method, uint32_t seed) {
+	if (layers <= 0)
+		throw Exception("Glass stack of no layers!");
+
+	SceneDescription scene = stage(String::format("glassStack%d", layers), method);
+	std::mt19937 mt(seed);
+	Palette palette(scene, MaterialMix(), mt);
+
+	const int glass = scene.addMaterial(IdealType::REFRACTIVE, Color::WHITE * 0.999);
+
+	// The row runs along -x from the origin, with a diffuse sphere at its end to look at.
+	for (int i = 0; i < layers; ++i)
+		scene.addSphere(Vector3D(-i * 2.1, 0, 1.5), 1, glass);
+
+	scene.addSphere(Vector3D(-layers * 2.1 - 2, 0, 2), 2, palette.pick(mt));
+
+	scene.eye = Vector3D(6, 0.3, 1.8);
+	scene.front = Vector3D(-1, 0, 0);
+	scene.up = Vector3D(0, 0, 1);
+	scene.fov = 30;
+
+	return scene;
+}
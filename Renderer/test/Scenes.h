@@ -0,0 +1,265 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C)  2016-2099, ZJU.
+//
+// File name:     Scenes.h
+//
+// Author:        Piu Zhang
+//
+// Version:       V1.0
+//
+// Date:          2026.10.19
+//
+// Description:   The scenes of the tests, shared by the demos, the benchmarks and the regression
+//                harness.
+//
+//                canonicalScenes() lists the ones the regression harness renders, each with the
+//                renderer it is meant for.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PXMImage.h"
+#include "Render.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "UnionGeometry.h"
+#include "PerspectiveCamera .h"
+#include "IdealMaterial.h"
+#include "PhongMaterial.h"
+#include "LambertMaterial.h"
+#include "CheckerMaterial .h"
+#include "DirectionalLight.h"
+#include "PointLight.h"
+#include "MyMath.h"
+
+#include <functional>
+#include <string>
+
+struct Scene {
+	enum Method { PATH_TRACE, RAY_TRACE, RENDER_LIGHT };
+
+	std::string name;
+	Method method;
+	UnionGeometry geometry;
+	vector<shared_ptr<Light>> lights;             // RAY_TRACE and RENDER_LIGHT only
+	int maxReflect;                               // RAY_TRACE only
+	std::function<PerspectiveCamera(const Size&)> camera;
+
+	Scene(const std::string& name, Method method, const UnionGeometry& geometry, const std::function<PerspectiveCamera(const Size&)>& camera,
+		const vector<shared_ptr<Light>>& lights = vector<shared_ptr<Light>>(), int maxReflect = 0)
+		: name(name)
+		, method(method)
+		, geometry(geometry)
+		, lights(lights)
+		, maxReflect(maxReflect)
+		, camera(camera)
+	{}
+};
+
+
+// Cornell box of smallpt, by Kevin Beason: walls are huge spheres. The front wall is black, so a
+// box without it looks the same from inside, and can be seen from the eye of smallpt behind it.
+UnionGeometry smallptScene(bool frontWall = true) {
+	auto sphere1 = make_shared<Sphere>(Vector3D(1e5+1,40.8,81.6),   1e5);   //Left
+	auto sphere2 = make_shared<Sphere>(Vector3D(-1e5+99,40.8,81.6), 1e5);	//Rght
+	auto sphere3 = make_shared<Sphere>(Vector3D(50, 40.8, 1e5),     1e5);   //Back
+	auto sphere4 = make_shared<Sphere>(Vector3D(50,40.8,-1e5+170),  1e5);  	//Frnt
+	auto sphere5 = make_shared<Sphere>(Vector3D(50, 1e5, 81.6),     1e5);	//Botm
+	auto sphere6 = make_shared<Sphere>(Vector3D(50,-1e5+81.6,81.6), 1e5);	//Top
+	auto sphere7 = make_shared<Sphere>(Vector3D(27,16.5,47),        16.5);	//Mirr
+	auto sphere8 = make_shared<Sphere>(Vector3D(73,16.5,78),        16.5);	//Glas
+	auto sphere9 = make_shared<Sphere>(Vector3D(50,681.6-.27,81.6), 600);	//Lite
+
+	sphere1->setMaterial(make_shared<IdealMaterial>(Color(.75, .25, .25), Color::BLACK, IdealType::DIFFUSE));    //Left
+	sphere2->setMaterial(make_shared<IdealMaterial>(Color(.25, .25, .75), Color::BLACK, IdealType::DIFFUSE));    //Rght
+	sphere3->setMaterial(make_shared<IdealMaterial>(Color(.75, .75, .75), Color::BLACK, IdealType::DIFFUSE));    //Back
+	sphere4->setMaterial(make_shared<IdealMaterial>(Color::BLACK,         Color::BLACK, IdealType::DIFFUSE));    //Frnt
+	sphere5->setMaterial(make_shared<IdealMaterial>(Color(.75, .75, .75), Color::BLACK, IdealType::DIFFUSE));    //Botm
+	sphere6->setMaterial(make_shared<IdealMaterial>(Color(.75, .75, .75), Color::BLACK, IdealType::DIFFUSE));    //Top
+	sphere7->setMaterial(make_shared<IdealMaterial>(Color::WHITE*.999,    Color::BLACK, IdealType::SPECULAR));   //Mirr
+	sphere8->setMaterial(make_shared<IdealMaterial>(Color::WHITE*.999,    Color::BLACK, IdealType::REFRACTIVE)); //Glas
+	sphere9->setMaterial(make_shared<IdealMaterial>(Color::BLACK,         Color::WHITE*12, IdealType::DIFFUSE)); //Lite
+
+	if (!frontWall) return UnionGeometry({ sphere1, sphere2, sphere3, sphere5, sphere6, sphere7, sphere8, sphere9 });
+
+	return UnionGeometry({ sphere1, sphere2, sphere3, sphere4, sphere5, sphere6, sphere7, sphere8, sphere9 });
+}
+
+// The view of smallpt, as a pinhole camera. smallpt starts its rays 140 units in front of the eye,
+// past the front wall, so this camera needs smallptScene(false).
+PerspectiveCamera smallptCamera(const Size& size) {
+	return PerspectiveCamera(Vector3D(50, 52, 295.6), Vector3D(0, -0.042612, -1), Vector3D(0, 1, 0), 2 * std::atan(0.5135 / 2) * 180 / Math::PI,
+		(1.0 * size.width()) / size.height());
+}
+
+UnionGeometry globalIlluminationScene() {
+	auto plane1 = make_shared<Plane>(Vector3D(0, 0, 1),    0);    // ground
+	auto plane2 = make_shared<Plane>(Vector3D(1, 0, 0),  -100);  // back
+	auto plane3 = make_shared<Plane>(Vector3D(0, 1, 0),  -60);  // left
+	auto plane4 = make_shared<Plane>(Vector3D(0, -1, 0), -60); // right
+	auto plane5 = make_shared<Plane>(Vector3D(0, 0, -1), -100); // ceil
+	auto plane6 = make_shared<Plane>(Vector3D(-1, 0, 0), -20);   // front
+
+	plane1->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.75, 0.75), Color::BLACK, IdealType::DIFFUSE));
+	plane2->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.75, 0.75), Color::BLACK, IdealType::DIFFUSE));
+	plane3->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.25, 0.25), Color::BLACK, IdealType::DIFFUSE));
+	plane4->setMaterial(make_shared<IdealMaterial>(Color(0.25, 0.25, 0.75), Color::BLACK, IdealType::DIFFUSE));
+	plane5->setMaterial(make_shared<IdealMaterial>(Color(0.75, 0.75, 0.75), Color::BLACK, IdealType::DIFFUSE));
+	plane6->setMaterial(make_shared<IdealMaterial>(Color(0.50, 0.84, 0.81), Color::BLACK, IdealType::DIFFUSE));
+
+	auto sphere1 = make_shared<Sphere>(Vector3D(-60, -27.5, 20), 20);
+	auto sphere2 = make_shared<Sphere>(Vector3D(-45, 30, 20), 20);
+	auto sphere3 = make_shared<Sphere>(Vector3D(-50, 0, 100 + 97), 100); // light
+
+	sphere1->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::SPECULAR));
+	sphere2->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
+	sphere3->setMaterial(make_shared<IdealMaterial>(Color(.75, .75, .75), Color(7.5, 7.5, 7.5), IdealType::DIFFUSE));
+
+	return UnionGeometry({ plane1, plane2, plane3, plane4, plane5, plane6, sphere1, sphere2, sphere3 });
+}
+
+PerspectiveCamera globalIlluminationCamera(const Size& size) {
+	return PerspectiveCamera(Vector3D(150, 0, 50), Vector3D(-1, 0, 0), Vector3D(0, 0, 1), 37, (1.0 * size.width()) / size.height());
+}
+
+// The global illumination room with the letters ICM made of glass balls. Its camera is globalIlluminationCamera().
+UnionGeometry icmScene() {
+	UnionGeometry geometries = globalIlluminationScene();
+
+	auto addBall = [&](const Vector3D& center, double radius) {
+		auto ball = make_shared<Sphere>(center, radius);
+		ball->setMaterial(make_shared<IdealMaterial>(Color(1, 1, 1), Color::BLACK, IdealType::REFRACTIVE));
+		geometries.add(ball);
+	};
+
+	double charX = 0, charY = 0, charZ = 70, r = 2;
+
+	// I
+	for (int i = 0; i < 6; ++i)
+		addBall(Vector3D(charX, -30 + charY, charZ - i*r*2), r);
+
+	// C
+	double R = 10, theta1 = Math::PI / 4., theta2 = Math::PI * 7 / 4.;
+	double delta = 2*r/R;
+
+	for (double theta = theta1; theta < Math::PI; theta += delta)
+		addBall(Vector3D(charX, -8 + charY + (R+1) * cos(theta), charZ-R + (R+1)*sin(theta)), r);
+
+	addBall(Vector3D(charX, -8 + charY + (R+1) * cos(Math::PI), charZ - R + (R+1)*sin(Math::PI)), r);
+
+	for (double theta = theta2; theta > Math::PI; theta -= delta)
+		addBall(Vector3D(charX, -8 + charY + (R+1) * cos(theta), charZ - R + (R+1)*sin(theta)), r);
+
+	// M
+	double mw = R*2;
+	for (int i = 0; i < 6; ++i) {
+		addBall(Vector3D(charX, 10 + charY, charZ - i*r * 2), r);
+		addBall(Vector3D(charX, 10 + mw + charY, charZ - i*r * 2), r);
+	}
+
+	// two balls at the upper corners
+	addBall(Vector3D(charX, 12 + charY, charZ-1), 2);
+	addBall(Vector3D(charX, 28 + charY, charZ-1), 2);
+
+	// one ball at the lower corner
+	addBall(Vector3D(charX, 10 + mw / 2 + charY, 54), 2);
+
+	int num = 5;
+	for (int i = 1; i <= num; ++i) {
+		addBall(Vector3D(charX, 10 + mw/2 + charY - i*8./num, 54 + i*15./(num)), 2);
+		addBall(Vector3D(charX, 10 + mw/2 + charY + i*8./num, 54 + i*15./(num)), 2);
+	}
+
+	return geometries;
+}
+
+// Checkered room with two Phong spheres, lit by three point lights.
+UnionGeometry planeAndSphereScene() {
+	auto plane1 = make_shared<Plane>(Vector3D(0, 0, 1), 0);    // bottom
+	auto plane2 = make_shared<Plane>(Vector3D(1, 0, 0), -20);  // back
+	auto plane3 = make_shared<Plane>(Vector3D(0, 1, 0), -30);  // left
+	auto plane4 = make_shared<Plane>(Vector3D(0, -1, 0), -30); // right
+	auto plane5 = make_shared<Plane>(Vector3D(0, 0, -1), -42); // top
+
+	// Two spheres
+	auto sphere1 = make_shared<Sphere>(Vector3D(-10, -12, 10), 10);
+	auto sphere2 = make_shared<Sphere>(Vector3D(-10, 12, 10), 10);
+
+	plane1->setMaterial(make_shared<CheckerMaterial>(0.1, 0.5));
+	plane2->setMaterial(make_shared<LambertMaterial>(Color(0, 0.5, 0.5)));
+	plane3->setMaterial(make_shared<LambertMaterial>(Color(0.5, 0.5, 0.5)));
+	plane4->setMaterial(make_shared<LambertMaterial>(Color(0, 0.2, 0.5)));
+	plane5->setMaterial(make_shared<LambertMaterial>(Color(0.25, 0.75, 0.25)));
+
+	sphere1->setMaterial(make_shared<PhongMaterial>(Color(1, 0, 0), Color::WHITE, 10, 0.25));
+	sphere2->setMaterial(make_shared<PhongMaterial>(Color(0.5, 0.5, 0.5), Color::WHITE, 16, 0.25));
+
+	return UnionGeometry({ plane1, plane2, plane3, plane4, plane5, sphere1, sphere2 });
+}
+
+vector<shared_ptr<Light>> planeAndSphereLights() {
+	return vector<shared_ptr<Light>>{
+		make_shared<PointLight>(Color::WHITE * 800, Vector3D(20, -20, 40)),
+		make_shared<PointLight>(Color::WHITE * 800, Vector3D(20, 0, 40)),
+		make_shared<PointLight>(Color::WHITE * 800, Vector3D(20, 20, 40)),
+	};
+}
+
+PerspectiveCamera planeAndSphereCamera(const Size& size) {
+	return PerspectiveCamera(Vector3D(20, 0, 20), Vector3D(-1, 0, 0), Vector3D(0, 0, 1), 90, (1.0 * size.width()) / size.height());
+}
+
+// Three planes and a sphere under a 6x6 grid of point lights and a fill light.
+UnionGeometry lights36Scene() {
+	return UnionGeometry({
+		make_shared<Plane>(Vector3D(0, 1, 0), 0),
+		make_shared<Plane>(Vector3D(0, 0, 1), -50),
+		make_shared<Plane>(Vector3D(1, 0, 0), -20),
+		make_shared<Sphere>(Vector3D(0, 10, -10), 10)
+	});
+}
+
+vector<shared_ptr<Light>> lights36Lights() {
+	vector<shared_ptr<Light>> lights;
+
+	for (int x = 10; x <= 30; x += 4) {
+		for (int z = 20; z <= 40; z += 4) {
+			lights.push_back(make_shared<PointLight>(Color::WHITE * 80, Vector3D(x, 50, z)));
+		}
+	}
+
+	lights.push_back(make_shared<DirectionalLight>(Color::WHITE*0.25, Vector3D(1.5, 1, 0.5)));
+
+	return lights;
+}
+
+PerspectiveCamera lights36Camera(const Size& size) {
+	return PerspectiveCamera(Vector3D(0, 10, 10), Vector3D(0, 0, -1), Vector3D(0, 1, 0), 90, (1.0 * size.width()) / size.height());
+}
+
+
+// Renders 'scene' with the renderer of its method; 'samples' is per pixel / 4, for the path tracer.
+// 'geometry', such as an acceleration structure over scene.geometry, is traced in its place.
+Matrix<uint8> renderScene(const Scene& scene, const Size& size, int samples, const Geometry* geometry = nullptr) {
+	const PerspectiveCamera camera = scene.camera(size);
+	const Geometry& traced = geometry ? *geometry : scene.geometry;
+
+	if (scene.method == Scene::PATH_TRACE) return Render::pathTrace(traced, camera, samples, size);
+
+	if (scene.method == Scene::RAY_TRACE) return Render::rayTrace(traced, scene.lights, camera, scene.maxReflect, size);
+
+	return Render::renderLight(traced, scene.lights, camera, size);
+}
+
+
+// The scenes of smallpt(), globalIlluminationTest(), renderICM(), render36LightsTest() and planeAndSphereTest().
+vector<Scene> canonicalScenes() {
+	return vector<Scene>{
+		Scene("smallpt", Scene::PATH_TRACE, smallptScene(false), smallptCamera),
+		Scene("globalIllumination", Scene::PATH_TRACE, globalIlluminationScene(), globalIlluminationCamera),
+		Scene("icm", Scene::PATH_TRACE, icmScene(), globalIlluminationCamera),
+		Scene("lights36", Scene::RENDER_LIGHT, lights36Scene(), lights36Camera, lights36Lights()),
+		Scene("planeAndSphere", Scene::RAY_TRACE, planeAndSphereScene(), planeAndSphereCamera, planeAndSphereLights(), 50),
+	};
+}